@@ -14,6 +14,10 @@ var Fetch = {
   attr_t_offset_overriddenMimeType: 76,
   attr_t_offset_requestData: 80,
   attr_t_offset_requestDataSize: 84,
+  attr_t_offset_destinationBuffer: 88,
+  attr_t_offset_destinationBufferSize: 92,
+  attr_t_offset_numDestinationBuffers: 96,
+  attr_t_offset_onbufferfilled: 100,
 
   fetch_t_offset_id: 0,
   fetch_t_offset_userData: 4,
@@ -28,6 +32,18 @@ var Fetch = {
   fetch_t_offset___proxyState: 108,
   fetch_t_offset___attributes: 112,
 
+  // Layout of struct __emscripten_fetch_queue in system/lib/fetch/emscripten_fetch.cpp: EMSCRIPTEN_FETCH_NUM_PRIORITIES
+  // ring buffers of proxied fetches, highest priority first, followed by the queue lock and the in-flight limit.
+  ring_t_offset_queuedOperations: 0,
+  ring_t_offset_head: 4,
+  ring_t_offset_tail: 8,
+  ring_t_offset_queueSize: 12,
+  ring_t_size: 16,
+  queue_t_num_priorities: 3,
+  queue_t_offset_lock: 48,
+  queue_t_offset_maxInFlight: 52,
+  queue_t_size: 56,
+
   xhrs: [],
   // The web worker that runs proxied file I/O requests.
   worker: undefined,
@@ -40,6 +56,48 @@ var Fetch = {
     HEAPU32[addr + 4 >> 2] = (val / 4294967296)|0;
   },
 
+  // If the fetch was given caller-provided destination buffers (emscripten_fetch_attr_t::destinationBuffer), returns a
+  // function write(bytes, finished) that copies the given Uint8Array into them, moving on to the next buffer of the
+  // ring and calling onbufferfilled() each time a buffer is full. Passing finished=true also hands over the last,
+  // partially filled buffer. Returns null if the fetch should allocate its data from the heap instead.
+  createDestinationBufferWriter: function(fetch) {
+    var fetch_attr = fetch + Fetch.fetch_t_offset___attributes;
+    var destinationBuffer = HEAPU32[fetch_attr + Fetch.attr_t_offset_destinationBuffer >> 2];
+    var destinationBufferSize = HEAPU32[fetch_attr + Fetch.attr_t_offset_destinationBufferSize >> 2];
+    if (!destinationBuffer || !destinationBufferSize) return null;
+    var numDestinationBuffers = HEAPU32[fetch_attr + Fetch.attr_t_offset_numDestinationBuffers >> 2] || 1;
+    var onbufferfilled = HEAPU32[fetch_attr + Fetch.attr_t_offset_onbufferfilled >> 2];
+    var bufferIndex = 0; // Index of the buffer in the ring that is currently being filled.
+    var bufferFill = 0; // Number of bytes written to the current buffer so far.
+    var bytesHandedOver = 0; // Number of bytes in all the buffers handed over to onbufferfilled() so far.
+
+    return function(bytes, finished) {
+      var pos = 0;
+      while (pos < bytes.length || (finished && bufferFill > 0)) {
+        var buffer = destinationBuffer + bufferIndex * destinationBufferSize;
+        var n = Math.min(bytes.length - pos, destinationBufferSize - bufferFill);
+        HEAPU8.set(bytes.subarray(pos, pos + n), buffer + bufferFill);
+        pos += n;
+        bufferFill += n;
+        if (bufferFill == destinationBufferSize || (finished && pos == bytes.length)) {
+          HEAPU32[fetch + Fetch.fetch_t_offset_data >> 2] = buffer;
+          Fetch.setu64(fetch + Fetch.fetch_t_offset_numBytes, bufferFill);
+          Fetch.setu64(fetch + Fetch.fetch_t_offset_dataOffset, bytesHandedOver);
+#if FETCH_DEBUG
+          console.log('fetch: filled destination buffer ' + bufferIndex + ' with ' + bufferFill + ' bytes');
+#endif
+          if (onbufferfilled && typeof dynCall === 'function') Module['dynCall_vi'](onbufferfilled, fetch);
+          bytesHandedOver += bufferFill;
+          bufferIndex = (bufferIndex + 1) % numDestinationBuffers;
+          bufferFill = 0;
+        }
+      }
+      // The data of the fetch is owned by the caller, so never leave it pointing to the buffers.
+      HEAPU32[fetch + Fetch.fetch_t_offset_data >> 2] = 0;
+      Fetch.setu64(fetch + Fetch.fetch_t_offset_numBytes, 0);
+    };
+  },
+
   openDatabase: function(dbname, dbversion, onsuccess, onerror) {
     try {
 #if FETCH_DEBUG
@@ -204,14 +262,19 @@ function __emscripten_fetch_load_cached_data(db, fetch, onsuccess, onerror) {
         console.log('fetch: Loaded file ' + pathStr + ' from IndexedDB, length: ' + len);
 #endif
 
-        // The data pointer malloc()ed here has the same lifetime as the emscripten_fetch_t structure itself has, and is
-        // freed when emscripten_fetch_close() is called.
-        var ptr = _malloc(len);
-        HEAPU8.set(new Uint8Array(value), ptr);
-        HEAPU32[fetch + Fetch.fetch_t_offset_data >> 2] = ptr;
-        Fetch.setu64(fetch + Fetch.fetch_t_offset_numBytes, len);
-        Fetch.setu64(fetch + Fetch.fetch_t_offset_dataOffset, 0);
         Fetch.setu64(fetch + Fetch.fetch_t_offset_totalBytes, len);
+        var writeToDestinationBuffers = Fetch.createDestinationBufferWriter(fetch);
+        if (writeToDestinationBuffers) {
+          writeToDestinationBuffers(new Uint8Array(value), true);
+        } else {
+          // The data pointer malloc()ed here has the same lifetime as the emscripten_fetch_t structure itself has, and is
+          // freed when emscripten_fetch_close() is called.
+          var ptr = _malloc(len);
+          HEAPU8.set(new Uint8Array(value), ptr);
+          HEAPU32[fetch + Fetch.fetch_t_offset_data >> 2] = ptr;
+          Fetch.setu64(fetch + Fetch.fetch_t_offset_numBytes, len);
+        }
+        Fetch.setu64(fetch + Fetch.fetch_t_offset_dataOffset, 0);
         HEAPU16[fetch + Fetch.fetch_t_offset_readyState >> 1] = 4; // Mimic XHR readyState 4 === 'DONE: The operation is complete'
         HEAPU16[fetch + Fetch.fetch_t_offset_status >> 1] = 200; // Mimic XHR HTTP status code 200 "OK"
         stringToUTF8("OK", fetch + Fetch.fetch_t_offset_statusText, 64);
@@ -366,13 +429,17 @@ function __emscripten_fetch_xhr(fetch, onsuccess, onerror, onprogress) {
   var id = Fetch.xhrs.length;
   HEAPU32[fetch + Fetch.fetch_t_offset_id >> 2] = id;
   var data = (dataPtr && dataLength) ? HEAPU8.slice(dataPtr, dataPtr + dataLength) : null;
+  var writeToDestinationBuffers = Fetch.createDestinationBufferWriter(fetch);
   // TODO: Support specifying custom headers to the request.
 
   xhr.onload = function(e) {
     var len = xhr.response ? xhr.response.byteLength : 0;
     var ptr = 0;
     var ptrLen = 0;
-    if (fetchAttrLoadToMemory && !fetchAttrStreamData) {
+    if (writeToDestinationBuffers) {
+      // Write the body straight to the caller's buffers, or if streaming, hand over the last partially filled buffer.
+      writeToDestinationBuffers((!fetchAttrStreamData && len) ? new Uint8Array(xhr.response) : new Uint8Array(0), true);
+    } else if (fetchAttrLoadToMemory && !fetchAttrStreamData) {
       ptrLen = len;
 #if FETCH_DEBUG
       console.log('fetch: allocating ' + ptrLen + ' bytes in Emscripten heap for xhr data');
@@ -433,7 +500,10 @@ function __emscripten_fetch_xhr(fetch, onsuccess, onerror, onprogress) {
   xhr.onprogress = function(e) {
     var ptrLen = (fetchAttrLoadToMemory && fetchAttrStreamData && xhr.response) ? xhr.response.byteLength : 0;
     var ptr = 0;
-    if (fetchAttrLoadToMemory && fetchAttrStreamData) {
+    if (writeToDestinationBuffers) {
+      if (fetchAttrStreamData && xhr.response) writeToDestinationBuffers(new Uint8Array(xhr.response), false);
+      ptrLen = 0;
+    } else if (fetchAttrLoadToMemory && fetchAttrStreamData) {
 #if FETCH_DEBUG
       console.log('fetch: allocating ' + ptrLen + ' bytes in Emscripten heap for xhr data');
 #endif
@@ -4,7 +4,7 @@
 /*global _malloc, _free, _memcpy*/
 /*global FUNCTION_TABLE, HEAP8, HEAPU8, HEAP16, HEAPU16, HEAP32, HEAPU32, HEAPF32, HEAPF64*/
 /*global readLatin1String*/
-/*global __emval_register, emval_handle_array, __emval_decref*/
+/*global __emval_register, __emval_decref*/
 /*global ___getTypeName*/
 /*global requireHandle*/
 /*jslint sub:true*/ /* The symbols 'fromWireType' and 'toWireType' must be accessed via array notation to be closure-safe since craftInvokerFunction crafts functions as strings that can't be closured. */
@@ -603,21 +603,70 @@ var LibraryEmbind = {
     return this['fromWireType'](HEAPU32[pointer >> 2]);
   },
 
+  // Short strings are carved out of the arena that bind.cpp registers
+  // instead of being malloc()ed; see StringArena in wire.h. The arena is
+  // only registered on the main runtime thread, so elsewhere these are
+  // plain malloc/free.
+  $embindStringArena: 0,
+
+  _embind_register_string_arena__deps: ['$embindStringArena'],
+  _embind_register_string_arena: function(arena) {
+    embindStringArena = arena;
+  },
+
+  $allocateWireString__deps: ['malloc', '$embindStringArena'],
+  $allocateWireString: function(size) {
+    if (embindStringArena) {
+      var a = embindStringArena >> 2; // { base, capacity, top, live }
+      var aligned = (size + 3) & ~3;
+      var top = HEAPU32[a + 2];
+      if (aligned <= HEAPU32[a + 1] - top) {
+        HEAPU32[a + 2] = top + aligned;
+        HEAPU32[a + 3] += 1;
+        return HEAPU32[a] + top;
+      }
+    }
+    return _malloc(size);
+  },
+
+  $releaseWireString__deps: ['free', '$embindStringArena'],
+  $releaseWireString: function(ptr) {
+    if (embindStringArena) {
+      var a = embindStringArena >> 2;
+      var base = HEAPU32[a];
+      if (ptr >= base && ptr < base + HEAPU32[a + 1]) {
+        if ((HEAPU32[a + 3] -= 1) === 0) {
+          HEAPU32[a + 2] = 0;
+        }
+        return;
+      }
+    }
+    _free(ptr);
+  },
+
+  // Decodes a run of code units straight from the heap, in chunks small
+  // enough to stay below engines' argument count limits.
+  $readWireStringChars: function(HEAP, start, length) {
+    var str = '';
+    for (var i = 0; i < length; i += 4096) {
+      var end = Math.min(length, i + 4096);
+      str += String.fromCharCode.apply(null, HEAP.subarray(start + i, start + end));
+    }
+    return str;
+  },
+
   _embind_register_std_string__deps: [
-    'free', 'malloc', '$readLatin1String', '$registerType',
-    '$simpleReadValueFromPointer', '$throwBindingError'],
+    '$allocateWireString', '$releaseWireString', '$readWireStringChars',
+    '$readLatin1String', '$registerType', '$simpleReadValueFromPointer', '$throwBindingError'],
   _embind_register_std_string: function(rawType, name) {
     name = readLatin1String(name);
     registerType(rawType, {
         name: name,
         'fromWireType': function(value) {
             var length = HEAPU32[value >> 2];
-            var a = new Array(length);
-            for (var i = 0; i < length; ++i) {
-                a[i] = String.fromCharCode(HEAPU8[value + 4 + i]);
-            }
-            _free(value);
-            return a.join('');
+            var str = readWireStringChars(HEAPU8, value + 4, length);
+            releaseWireString(value);
+            return str;
         },
         'toWireType': function(destructors, value) {
             if (value instanceof ArrayBuffer) {
@@ -645,30 +694,30 @@ var LibraryEmbind = {
 
             // assumes 4-byte alignment
             var length = value.length;
-            var ptr = _malloc(4 + length);
+            var ptr = allocateWireString(4 + length);
             HEAPU32[ptr >> 2] = length;
             for (var i = 0; i < length; ++i) {
                 var charCode = getElement(value, i);
                 if (charCode > 255) {
-                    _free(ptr);
+                    releaseWireString(ptr);
                     throwBindingError('String has UTF-16 code units that do not fit in 8 bits');
                 }
                 HEAPU8[ptr + 4 + i] = charCode;
             }
             if (destructors !== null) {
-                destructors.push(_free, ptr);
+                destructors.push(releaseWireString, ptr);
             }
             return ptr;
         },
         'argPackAdvance': 8,
         'readValueFromPointer': simpleReadValueFromPointer,
-        destructorFunction: function(ptr) { _free(ptr); },
+        destructorFunction: function(ptr) { releaseWireString(ptr); },
     });
   },
 
   _embind_register_std_wstring__deps: [
-    'free', 'malloc', '$readLatin1String', '$registerType',
-    '$simpleReadValueFromPointer'],
+    '$allocateWireString', '$releaseWireString', '$readWireStringChars',
+    '$readLatin1String', '$registerType', '$simpleReadValueFromPointer'],
   _embind_register_std_wstring: function(rawType, charSize, name) {
     // nb. do not cache HEAPU16 and HEAPU32, they may be destroyed by enlargeMemory().
     name = readLatin1String(name);
@@ -683,46 +732,41 @@ var LibraryEmbind = {
     registerType(rawType, {
         name: name,
         'fromWireType': function(value) {
-            var HEAP = getHeap();
             var length = HEAPU32[value >> 2];
-            var a = new Array(length);
-            var start = (value + 4) >> shift;
-            for (var i = 0; i < length; ++i) {
-                a[i] = String.fromCharCode(HEAP[start + i]);
-            }
-            _free(value);
-            return a.join('');
+            var str = readWireStringChars(getHeap(), (value + 4) >> shift, length);
+            releaseWireString(value);
+            return str;
         },
         'toWireType': function(destructors, value) {
             // assumes 4-byte alignment
-            var HEAP = getHeap();
             var length = value.length;
-            var ptr = _malloc(4 + length * charSize);
+            var ptr = allocateWireString(4 + length * charSize);
+            var HEAP = getHeap();
             HEAPU32[ptr >> 2] = length;
             var start = (ptr + 4) >> shift;
             for (var i = 0; i < length; ++i) {
                 HEAP[start + i] = value.charCodeAt(i);
             }
             if (destructors !== null) {
-                destructors.push(_free, ptr);
+                destructors.push(releaseWireString, ptr);
             }
             return ptr;
         },
         'argPackAdvance': 8,
         'readValueFromPointer': simpleReadValueFromPointer,
-        destructorFunction: function(ptr) { _free(ptr); },
+        destructorFunction: function(ptr) { releaseWireString(ptr); },
     });
   },
 
   _embind_register_emval__deps: [
-    '_emval_decref', '$emval_handle_array', '_emval_register',
+    '_emval_decref', '$requireHandle', '_emval_register',
     '$readLatin1String', '$registerType', '$simpleReadValueFromPointer'],
   _embind_register_emval: function(rawType, name) {
     name = readLatin1String(name);
     registerType(rawType, {
         name: name,
         'fromWireType': function(handle) {
-            var rv = emval_handle_array[handle].value;
+            var rv = requireHandle(handle);
             __emval_decref(handle);
             return rv;
         },
@@ -816,8 +860,17 @@ var LibraryEmbind = {
   // The path to interop from JS code to C++ code:
   // (hand-written JS code) -> (autogenerated JS invoker) -> (template-generated C++ invoker) -> (target C++ function)
   // craftInvokerFunction generates the JS invoker function for each function exposed to JS through embind.
+#if EMBIND_STATIC_INVOKERS
+  $embindStaticInvokers__deps: ['$runDestructors', '$throwBindingError'],
+  $embindStaticInvokers: {{{ makeEmbindStaticInvokers() }}},
+
+#endif
   $craftInvokerFunction__deps: [
-    '$makeLegalFunctionName', '$new_', '$runDestructors', '$throwBindingError'],
+    '$makeLegalFunctionName', '$new_', '$runDestructors', '$throwBindingError'
+#if EMBIND_STATIC_INVOKERS
+    , '$embindStaticInvokers'
+#endif
+  ],
   $craftInvokerFunction: function(humanName, argTypes, classType, cppInvokerFunc, cppTargetFunc) {
     // humanName: a human-readable string name for the function to be generated.
     // argTypes: An array that contains the embind type objects for all types in the function signature.
@@ -855,6 +908,13 @@ var LibraryEmbind = {
 
     var returns = (argTypes[0].name !== "void");
 
+#if EMBIND_STATIC_INVOKERS
+    var staticInvoker = embindStaticInvokers[(isClassMethodFunc ? 'm' : 'f') + (returns ? 'r' : 'v') + (argCount - 2)];
+    if (staticInvoker) {
+        return staticInvoker(humanName, argTypes, cppInvokerFunc, cppTargetFunc, needsDestructorStack);
+    }
+
+#endif
 #if NO_DYNAMIC_EXECUTION
     var argsWired = new Array(argCount - 2);
     return function() {
@@ -1,51 +1,96 @@
 /*global Module:true, Runtime*/
-/*global HEAP32*/
+/*global HEAP32, HEAPU32, HEAPF64*/
 /*global new_*/
 /*global createNamedFunction*/
-/*global readLatin1String, stringToUTF8*/
+/*global readLatin1String, stringToUTF8, UTF8ToString*/
 /*global requireRegisteredType, throwBindingError, runDestructors*/
 /*jslint sub:true*/ /* The symbols 'fromWireType' and 'toWireType' must be accessed via array notation to be closure-safe since craftInvokerFunction crafts functions as strings that can't be closured. */
 
 // -- jshint doesn't understand library syntax, so we need to mark the symbols exposed here
-/*global getStringOrSymbol, emval_handle_array, __emval_register, __emval_unregister, requireHandle, count_emval_handles, emval_symbols, emval_free_list, get_first_emval, __emval_decref, emval_newers*/
+/*global getStringOrSymbol, getUTF8StringOrSymbol, emval_values, emval_refcounts, emval_generations, emval_free_head, emval_stats, emval_handle_stats, __emval_register, __emval_unregister, requireHandle, count_emval_handles, emval_symbols, get_first_emval, __emval_decref, emval_newers*/
 /*global craftEmvalAllocator, __emval_addMethodCaller, emval_methodCallers, LibraryManager, mergeInto, __emval_allocateDestructors, global, __emval_lookupTypes, makeLegalFunctionName*/
 /*global emval_get_global*/
 
 var LibraryEmVal = {
-  $emval_handle_array: [{},
-    {value: undefined},{value: null},
-    {value: true},{value: false}], // reserve zero and special values
-  $emval_free_list: [],
+  // Handles are an index into these parallel arrays in their low 22 bits,
+  // with the slot's 9-bit generation above that, so that a stale handle to
+  // a reused slot is detected instead of silently aliasing the new value.
+  // Slot 0 is never used and slots 1-4 hold the reserved values, whose
+  // handles are never reference counted. Free slots have a refcount <= 0
+  // and are chained through it: -refcount is the next free slot, and 0
+  // ends the list.
+  $emval_values: [undefined, undefined, null, true, false],
+  $emval_refcounts: [0, 1, 1, 1, 1],
+  $emval_generations: [0, 0, 0, 0, 0],
+  $emval_free_head: 0,
+#if ASSERTIONS
+  $emval_stats: {registered: 0, freed: 0, peak: 0},
+#endif
   $emval_symbols: {}, // address -> string
 
-  $init_emval__deps: ['$count_emval_handles', '$get_first_emval'],
+  $init_emval__deps: ['$count_emval_handles', '$get_first_emval'
+#if ASSERTIONS
+    , '$emval_handle_stats'
+#endif
+  ],
   $init_emval__postset: 'init_emval();',
   $init_emval: function() {
     Module['count_emval_handles'] = count_emval_handles;
     Module['get_first_emval'] = get_first_emval;
+#if ASSERTIONS
+    Module['emval_handle_stats'] = emval_handle_stats;
+#endif
   },
 
-  $count_emval_handles__deps: ['$emval_handle_array'],
+  $count_emval_handles__deps: ['$emval_refcounts'],
   $count_emval_handles: function() {
     var count = 0;
-    for (var i = 5; i < emval_handle_array.length; ++i) {
-        if (emval_handle_array[i] !== undefined) {
+    for (var i = 5; i < emval_refcounts.length; ++i) {
+        if (emval_refcounts[i] > 0) {
             ++count;
         }
     }
     return count;
   },
 
-  $get_first_emval__deps: ['$emval_handle_array'],
+  $get_first_emval__deps: ['$emval_values', '$emval_refcounts'],
   $get_first_emval: function() {
-    for (var i = 5; i < emval_handle_array.length; ++i) {
-        if (emval_handle_array[i] !== undefined) {
-            return emval_handle_array[i];
+    for (var i = 5; i < emval_refcounts.length; ++i) {
+        if (emval_refcounts[i] > 0) {
+            return {refcount: emval_refcounts[i], value: emval_values[i]};
         }
     }
     return null;
   },
 
+#if ASSERTIONS
+  // Returns counters for tracking down leaked vals: how many handles were
+  // ever registered and freed, the peak and current number of live
+  // handles, the size of the table, and the live handles grouped by the
+  // type of their value.
+  $emval_handle_stats__deps: ['$emval_values', '$emval_refcounts', '$emval_stats'],
+  $emval_handle_stats: function() {
+    var liveByType = {};
+    var live = 0;
+    for (var i = 5; i < emval_refcounts.length; ++i) {
+        if (emval_refcounts[i] > 0) {
+            var value = emval_values[i];
+            var type = (value !== null && typeof value === 'object' && value.constructor) ? value.constructor.name || 'object' : typeof value;
+            liveByType[type] = (liveByType[type] || 0) + 1;
+            ++live;
+        }
+    }
+    return {
+        registered: emval_stats.registered,
+        freed: emval_stats.freed,
+        live: live,
+        peak: emval_stats.peak,
+        capacity: emval_refcounts.length,
+        liveByType: liveByType
+    };
+  },
+#endif
+
   _emval_register_symbol__deps: ['$emval_symbols', '$readLatin1String'],
   _emval_register_symbol: function(address) {
     emval_symbols[address] = readLatin1String(address);
@@ -61,15 +106,27 @@ var LibraryEmVal = {
     }
   },
 
-  $requireHandle__deps: ['$emval_handle_array', '$throwBindingError'],
+  // Like getStringOrSymbol, but for arbitrary C strings, which are UTF-8.
+  $getUTF8StringOrSymbol__deps: ['$emval_symbols'],
+  $getUTF8StringOrSymbol: function(address) {
+    var symbol = emval_symbols[address];
+    return symbol === undefined ? UTF8ToString(address) : symbol;
+  },
+
+  $requireHandle__deps: ['$emval_values', '$emval_refcounts', '$emval_generations', '$throwBindingError'],
   $requireHandle: function(handle) {
-    if (!handle) {
+    var index = handle & 0x3FFFFF;
+    if (!handle || !(emval_refcounts[index] > 0) || emval_generations[index] !== (handle >>> 22)) {
         throwBindingError('Cannot use deleted val. handle = ' + handle);
     }
-    return emval_handle_array[handle].value;
+    return emval_values[index];
   },
 
-  _emval_register__deps: ['$emval_free_list', '$emval_handle_array', '$init_emval'],
+  _emval_register__deps: ['$emval_values', '$emval_refcounts', '$emval_generations', '$emval_free_head', '$init_emval', '$throwBindingError'
+#if ASSERTIONS
+    , '$emval_stats'
+#endif
+  ],
   _emval_register: function(value) {
 
     switch(value){
@@ -78,34 +135,67 @@ var LibraryEmVal = {
       case true :{ return 3; }
       case false :{ return 4; }
       default:{
-        var handle = emval_free_list.length ?
-            emval_free_list.pop() :
-            emval_handle_array.length;
-
-        emval_handle_array[handle] = {refcount: 1, value: value};
-        return handle;
+        var index = emval_free_head;
+        if (index) {
+            emval_free_head = -emval_refcounts[index];
+        } else {
+            index = emval_values.length;
+            if (index > 0x3FFFFF) {
+                throwBindingError('Too many live vals');
+            }
+            emval_generations.push(0);
+        }
+        emval_values[index] = value;
+        emval_refcounts[index] = 1;
+#if ASSERTIONS
+        var live = ++emval_stats.registered - emval_stats.freed;
+        if (live > emval_stats.peak) emval_stats.peak = live;
+#endif
+        return (emval_generations[index] << 22) | index;
         }
       }
   },
 
-  _emval_incref__deps: ['$emval_handle_array'],
+  _emval_incref__deps: ['$emval_refcounts'
+#if ASSERTIONS
+    , '$requireHandle'
+#endif
+  ],
   _emval_incref: function(handle) {
     if (handle > 4) {
-        emval_handle_array[handle].refcount += 1;
+#if ASSERTIONS
+        requireHandle(handle);
+#endif
+        emval_refcounts[handle & 0x3FFFFF] += 1;
     }
   },
 
-  _emval_decref__deps: ['$emval_free_list', '$emval_handle_array'],
+  _emval_decref__deps: ['$emval_values', '$emval_refcounts', '$emval_generations', '$emval_free_head'
+#if ASSERTIONS
+    , '$requireHandle', '$emval_stats'
+#endif
+  ],
   _emval_decref: function(handle) {
-    if (handle > 4 && 0 === --emval_handle_array[handle].refcount) {
-        emval_handle_array[handle] = undefined;
-        emval_free_list.push(handle);
+    if (handle > 4) {
+#if ASSERTIONS
+        requireHandle(handle);
+#endif
+        var index = handle & 0x3FFFFF;
+        if (0 === --emval_refcounts[index]) {
+            emval_values[index] = undefined;
+            emval_generations[index] = (emval_generations[index] + 1) & 0x1FF;
+            emval_refcounts[index] = -emval_free_head;
+            emval_free_head = index;
+#if ASSERTIONS
+            ++emval_stats.freed;
+#endif
+        }
     }
   },
 
-  _emval_run_destructors__deps: ['_emval_decref', '$emval_handle_array', '$runDestructors'],
+  _emval_run_destructors__deps: ['_emval_decref', '$requireHandle', '$runDestructors'],
   _emval_run_destructors: function(handle) {
-    var destructors = emval_handle_array[handle].value;
+    var destructors = requireHandle(handle);
     runDestructors(destructors);
     __emval_decref(handle);
   },
@@ -247,6 +337,17 @@ var LibraryEmVal = {
     return __emval_register(handle[key]);
   },
 
+  // Like _emval_get_property, but consumes the caller's reference to
+  // the object, so that a temporary in a chain like v["a"]["b"] is
+  // released here rather than with a separate _emval_decref call. When
+  // that frees the temporary's slot, the result immediately reuses it.
+  _emval_take_property__deps: ['_emval_decref', '_emval_register', '$requireHandle'],
+  _emval_take_property: function(handle, key) {
+    var value = requireHandle(handle)[requireHandle(key)];
+    __emval_decref(handle);
+    return __emval_register(value);
+  },
+
   _emval_set_property__deps: ['$requireHandle'],
   _emval_set_property: function(handle, key, value) {
     handle = requireHandle(handle);
@@ -407,6 +508,68 @@ var LibraryEmVal = {
     caller(handle, methodName, null, args);
   },
 
+  // Runs the commands recorded by emscripten::val_batch (see the Command
+  // enum in val.h). Every command that produces a value appends it to
+  // slots, so slot numbers are implicit.
+  _emval_run_batch__deps: ['_emval_register', '$getUTF8StringOrSymbol', '$requireHandle', '$throwBindingError'],
+  _emval_run_batch: function(commands, commandCount, numbers, values, numberResults) {
+    var slots = [];
+    var p = commands >> 2;
+    var end = p + commandCount;
+    while (p < end) {
+      switch (HEAPU32[p]) {
+        case 0: // INPUT handle
+          slots.push(requireHandle(HEAPU32[p + 1]));
+          p += 2;
+          break;
+        case 1: // NUMBER index
+          slots.push(HEAPF64[(numbers >> 3) + HEAPU32[p + 1]]);
+          p += 2;
+          break;
+        case 2: // STRING name
+          slots.push(getUTF8StringOrSymbol(HEAPU32[p + 1]));
+          p += 2;
+          break;
+        case 3: // GET object, name
+          slots.push(slots[HEAPU32[p + 1]][getUTF8StringOrSymbol(HEAPU32[p + 2])]);
+          p += 3;
+          break;
+        case 4: // GET_INDEX object, index
+          slots.push(slots[HEAPU32[p + 1]][HEAPU32[p + 2]]);
+          p += 3;
+          break;
+        case 5: // SET object, name, value
+          slots[HEAPU32[p + 1]][getUTF8StringOrSymbol(HEAPU32[p + 2])] = slots[HEAPU32[p + 3]];
+          p += 4;
+          break;
+        case 6: // SET_INDEX object, index, value
+          slots[HEAPU32[p + 1]][HEAPU32[p + 2]] = slots[HEAPU32[p + 3]];
+          p += 4;
+          break;
+        case 7: // CALL object, name, argCount, args...
+          var object = slots[HEAPU32[p + 1]];
+          var argCount = HEAPU32[p + 3];
+          var args = new Array(argCount);
+          for (var i = 0; i < argCount; ++i) {
+            args[i] = slots[HEAPU32[p + 4 + i]];
+          }
+          slots.push(object[getUTF8StringOrSymbol(HEAPU32[p + 2])].apply(object, args));
+          p += 4 + argCount;
+          break;
+        case 8: // KEEP slot, index
+          HEAPU32[(values >> 2) + HEAPU32[p + 2]] = __emval_register(slots[HEAPU32[p + 1]]);
+          p += 3;
+          break;
+        case 9: // READ_NUMBER slot, index
+          HEAPF64[(numberResults >> 3) + HEAPU32[p + 2]] = +slots[HEAPU32[p + 1]];
+          p += 3;
+          break;
+        default:
+          throwBindingError('Invalid val_batch command ' + HEAPU32[p]);
+      }
+    }
+  },
+
   _emval_typeof__deps: ['_emval_register', '$requireHandle'],
   _emval_typeof: function(handle) {
     handle = requireHandle(handle);
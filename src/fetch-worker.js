@@ -97,38 +97,69 @@ var HEAPU16 = null;
 var HEAP32 = null;
 var HEAPU32 = null;
 
+// Number of proxied fetches this worker has started that have not yet finished.
+var numFetchesInFlight = 0;
+
+function lockWorkQueue() {
+  while (Atomics_compareExchange(HEAPU32, queuePtr + Fetch.queue_t_offset_lock >> 2, 0, 1) != 0) { /* spin */ }
+}
+
+function unlockWorkQueue() {
+  Atomics_store(HEAPU32, queuePtr + Fetch.queue_t_offset_lock >> 2, 0);
+}
+
+// Pops the oldest fetch from the highest priority nonempty ring, or returns 0 if all rings are empty.
+// Must be called with the work queue locked.
+function dequeueFetch() {
+  for(var i = 0; i < Fetch.queue_t_num_priorities; ++i) {
+    var ring = queuePtr + i * Fetch.ring_t_size;
+    var head = HEAPU32[ring + Fetch.ring_t_offset_head >> 2];
+    var tail = HEAPU32[ring + Fetch.ring_t_offset_tail >> 2];
+    if (head == tail) continue;
+    var queuedOperations = HEAPU32[ring + Fetch.ring_t_offset_queuedOperations >> 2];
+    var queueSize = HEAPU32[ring + Fetch.ring_t_offset_queueSize >> 2];
+    var fetch = HEAPU32[(queuedOperations >> 2) + (head & (queueSize - 1))];
+    HEAPU32[ring + Fetch.ring_t_offset_head >> 2] = head + 1;
+    return fetch;
+  }
+  return 0;
+}
+
+function finishFetch(fetch) {
+  --numFetchesInFlight;
+  Atomics.compareExchange(HEAPU32, fetch + Fetch.fetch_t_offset___proxyState >> 2, 1, 2);
+  Atomics.wake(HEAP32, fetch + Fetch.fetch_t_offset___proxyState >> 2, 1);
+  // A slot freed up, so start the next queued fetch right away instead of waiting for the next poll.
+  setTimeout(processWorkQueue, 0);
+}
+
 function processWorkQueue() {
   if (!queuePtr) return;
-  var numQueuedItems = Atomics_load(HEAPU32, queuePtr + 4 >> 2);
-  if (numQueuedItems == 0) return;
+  for(;;) {
+    var maxInFlight = Atomics_load(HEAPU32, queuePtr + Fetch.queue_t_offset_maxInFlight >> 2);
+    if (maxInFlight && numFetchesInFlight >= maxInFlight) return;
+
+    lockWorkQueue();
+    var fetch = dequeueFetch();
+    unlockWorkQueue();
+    if (!fetch) return;
 
-  var queuedOperations = Atomics_load(HEAPU32, queuePtr >> 2);
-  var queueSize = Atomics_load(HEAPU32, queuePtr + 8 >> 2);
-  for(var i = 0; i < numQueuedItems; ++i) {
-    var fetch = Atomics_load(HEAPU32, (queuedOperations >> 2)+i);
     function successcb(fetch) {
-      Atomics.compareExchange(HEAPU32, fetch + Fetch.fetch_t_offset___proxyState >> 2, 1, 2);
-      Atomics.wake(HEAP32, fetch + Fetch.fetch_t_offset___proxyState >> 2, 1);
+      finishFetch(fetch);
     }
     function errorcb(fetch) {
-      Atomics.compareExchange(HEAPU32, fetch + Fetch.fetch_t_offset___proxyState >> 2, 1, 2);
-      Atomics.wake(HEAP32, fetch + Fetch.fetch_t_offset___proxyState >> 2, 1);
+      finishFetch(fetch);
     }
     function progresscb(fetch) {
     }
+    ++numFetchesInFlight;
     try {
       emscripten_start_fetch(fetch, successcb, errorcb, progresscb);
     } catch(e) {
       console.error(e);
+      finishFetch(fetch);
     }
-    /*
-    if (interval != undefined) {
-      clearInterval(interval);
-      interval = undefined;
-    }
-    */
   }
-  Atomics_store(HEAPU32, queuePtr + 4 >> 2, 0);
 }
 
 interval = 0;
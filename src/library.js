@@ -541,6 +541,23 @@ LibraryManager.library = {
     return 0;
   },
 
+  // Makes sure the next |bytes| bytes of the dynamic heap are backed by memory, growing it now if need be,
+  // so that a program about to allocate a lot does not pay for several growths (each a full copy) on the way.
+  emscripten_heap_reserve: function(bytes) {
+    var requestedSize = HEAP32[DYNAMICTOP_PTR>>2] + bytes;
+    if (bytes < 0 || requestedSize > 2147483647) return 0;
+    if (requestedSize <= TOTAL_MEMORY) return 1;
+#if USE_PTHREADS
+    return 0;
+#else
+#if ALLOW_MEMORY_GROWTH
+    return enlargeMemory(requestedSize) ? 1 : 0;
+#else
+    return 0;
+#endif
+#endif
+  },
+
   system__deps: ['__setErrNo', '$ERRNO_CODES'],
   system: function(command) {
     // int system(const char *command);
@@ -813,6 +830,8 @@ LibraryManager.library = {
     var aligned_dest_end = 0;
     var block_aligned_dest_end = 0;
     var dest_end = 0;
+    var words = 0;
+    var src_word = 0, shift = 0, word = 0, next = 0;
     // Test against a benchmarked cutoff limit for when HEAPU8.set() becomes faster to use.
     if ((num|0) >=
 #if SIMD
@@ -826,62 +845,92 @@ LibraryManager.library = {
 
     ret = dest|0;
     dest_end = (dest + num)|0;
-    if ((dest&3) == (src&3)) {
-      // The initial unaligned < 4-byte front.
-      while (dest & 3) {
-        if ((num|0) == 0) return ret|0;
-        {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i8'), 'i8') }}};
-        dest = (dest+1)|0;
-        src = (src+1)|0;
-        num = (num-1)|0;
-      }
-      aligned_dest_end = (dest_end & -4)|0;
-      block_aligned_dest_end = (aligned_dest_end - 64)|0;
-      while ((dest|0) <= (block_aligned_dest_end|0) ) {
+    // Copies of less than 8 bytes are done by the byte loop at the end, without any alignment work.
+    if ((num|0) >= 8) {
+      if ((dest&3) == (src&3)) {
+        // The initial unaligned < 4-byte front.
+        while (dest & 3) {
+          {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i8'), 'i8') }}};
+          dest = (dest+1)|0;
+          src = (src+1)|0;
+        }
+        aligned_dest_end = (dest_end & -4)|0;
+        block_aligned_dest_end = (aligned_dest_end - 64)|0;
+        while ((dest|0) <= (block_aligned_dest_end|0) ) {
 #if SIMD
-        SIMD_Int32x4_store(HEAPU8, dest, SIMD_Int32x4_load(HEAPU8, src));
-        SIMD_Int32x4_store(HEAPU8, dest+16, SIMD_Int32x4_load(HEAPU8, src+16));
-        SIMD_Int32x4_store(HEAPU8, dest+32, SIMD_Int32x4_load(HEAPU8, src+32));
-        SIMD_Int32x4_store(HEAPU8, dest+48, SIMD_Int32x4_load(HEAPU8, src+48));
+          SIMD_Int32x4_store(HEAPU8, dest, SIMD_Int32x4_load(HEAPU8, src));
+          SIMD_Int32x4_store(HEAPU8, dest+16, SIMD_Int32x4_load(HEAPU8, src+16));
+          SIMD_Int32x4_store(HEAPU8, dest+32, SIMD_Int32x4_load(HEAPU8, src+32));
+          SIMD_Int32x4_store(HEAPU8, dest+48, SIMD_Int32x4_load(HEAPU8, src+48));
 #else
-        {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 4, makeGetValueAsm('src', 4, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 8, makeGetValueAsm('src', 8, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 12, makeGetValueAsm('src', 12, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 16, makeGetValueAsm('src', 16, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 20, makeGetValueAsm('src', 20, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 24, makeGetValueAsm('src', 24, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 28, makeGetValueAsm('src', 28, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 32, makeGetValueAsm('src', 32, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 36, makeGetValueAsm('src', 36, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 40, makeGetValueAsm('src', 40, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 44, makeGetValueAsm('src', 44, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 48, makeGetValueAsm('src', 48, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 52, makeGetValueAsm('src', 52, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 56, makeGetValueAsm('src', 56, 'i32'), 'i32') }}};
-        {{{ makeSetValueAsm('dest', 60, makeGetValueAsm('src', 60, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 4, makeGetValueAsm('src', 4, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 8, makeGetValueAsm('src', 8, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 12, makeGetValueAsm('src', 12, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 16, makeGetValueAsm('src', 16, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 20, makeGetValueAsm('src', 20, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 24, makeGetValueAsm('src', 24, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 28, makeGetValueAsm('src', 28, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 32, makeGetValueAsm('src', 32, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 36, makeGetValueAsm('src', 36, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 40, makeGetValueAsm('src', 40, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 44, makeGetValueAsm('src', 44, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 48, makeGetValueAsm('src', 48, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 52, makeGetValueAsm('src', 52, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 56, makeGetValueAsm('src', 56, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 60, makeGetValueAsm('src', 60, 'i32'), 'i32') }}};
 #endif
-        dest = (dest+64)|0;
-        src = (src+64)|0;
-      }
-      while ((dest|0) < (aligned_dest_end|0) ) {
-        {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i32'), 'i32') }}};
-        dest = (dest+4)|0;
-        src = (src+4)|0;
-      }
-    } else {
-      // In the unaligned copy case, unroll a bit as well.
-      aligned_dest_end = (dest_end - 4)|0;
-      while ((dest|0) < (aligned_dest_end|0) ) {
-        {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i8'), 'i8') }}};
-        {{{ makeSetValueAsm('dest', 1, makeGetValueAsm('src', 1, 'i8'), 'i8') }}};
-        {{{ makeSetValueAsm('dest', 2, makeGetValueAsm('src', 2, 'i8'), 'i8') }}};
-        {{{ makeSetValueAsm('dest', 3, makeGetValueAsm('src', 3, 'i8'), 'i8') }}};
-        dest = (dest+4)|0;
-        src = (src+4)|0;
+          dest = (dest+64)|0;
+          src = (src+64)|0;
+        }
+        // Less than 64 aligned bytes are left: jump straight into a run of word copies of the right length. The
+        // copies are addressed back from the aligned end so that they still go in ascending order, which memmove
+        // relies on.
+        words = ((aligned_dest_end - dest)|0) >> 2;
+        src = (src + ((aligned_dest_end - dest)|0))|0;
+        dest = aligned_dest_end;
+        switch (words|0) {
+          case 15: {{{ makeSetValueAsm('dest', -60, makeGetValueAsm('src', -60, 'i32'), 'i32') }}};
+          case 14: {{{ makeSetValueAsm('dest', -56, makeGetValueAsm('src', -56, 'i32'), 'i32') }}};
+          case 13: {{{ makeSetValueAsm('dest', -52, makeGetValueAsm('src', -52, 'i32'), 'i32') }}};
+          case 12: {{{ makeSetValueAsm('dest', -48, makeGetValueAsm('src', -48, 'i32'), 'i32') }}};
+          case 11: {{{ makeSetValueAsm('dest', -44, makeGetValueAsm('src', -44, 'i32'), 'i32') }}};
+          case 10: {{{ makeSetValueAsm('dest', -40, makeGetValueAsm('src', -40, 'i32'), 'i32') }}};
+          case 9: {{{ makeSetValueAsm('dest', -36, makeGetValueAsm('src', -36, 'i32'), 'i32') }}};
+          case 8: {{{ makeSetValueAsm('dest', -32, makeGetValueAsm('src', -32, 'i32'), 'i32') }}};
+          case 7: {{{ makeSetValueAsm('dest', -28, makeGetValueAsm('src', -28, 'i32'), 'i32') }}};
+          case 6: {{{ makeSetValueAsm('dest', -24, makeGetValueAsm('src', -24, 'i32'), 'i32') }}};
+          case 5: {{{ makeSetValueAsm('dest', -20, makeGetValueAsm('src', -20, 'i32'), 'i32') }}};
+          case 4: {{{ makeSetValueAsm('dest', -16, makeGetValueAsm('src', -16, 'i32'), 'i32') }}};
+          case 3: {{{ makeSetValueAsm('dest', -12, makeGetValueAsm('src', -12, 'i32'), 'i32') }}};
+          case 2: {{{ makeSetValueAsm('dest', -8, makeGetValueAsm('src', -8, 'i32'), 'i32') }}};
+          case 1: {{{ makeSetValueAsm('dest', -4, makeGetValueAsm('src', -4, 'i32'), 'i32') }}};
+        }
+      } else {
+        // Differently aligned source and destination. Align the destination, then build each destination word from
+        // the two aligned source words it straddles, so that all the loads and stores in the loop are aligned. The
+        // second of those words runs past the bytes this destination word needs, so the loop stops a word early,
+        // leaving the last one to the byte loop, and never reads past the end of the source.
+        while (dest & 3) {
+          {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i8'), 'i8') }}};
+          dest = (dest+1)|0;
+          src = (src+1)|0;
+        }
+        aligned_dest_end = (dest_end & -4)|0;
+        shift = (src & 3) << 3;
+        src_word = src & -4;
+        word = {{{ makeGetValueAsm('src_word', 0, 'i32') }}};
+        while (((dest + 4)|0) < (aligned_dest_end|0) ) {
+          next = {{{ makeGetValueAsm('src_word', 4, 'i32') }}};
+          {{{ makeSetValueAsm('dest', 0, '(word >>> shift) | (next << (32 - shift))', 'i32') }}};
+          word = next;
+          dest = (dest+4)|0;
+          src_word = (src_word+4)|0;
+        }
+        src = (src_word + (shift >> 3))|0;
       }
     }
-    // The remaining unaligned < 4 byte tail.
+    // The remaining unaligned < 4 byte tail, or all of a small copy.
     while ((dest|0) < (dest_end|0)) {
       {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i8'), 'i8') }}};
       dest = (dest+1)|0;
@@ -897,15 +946,50 @@ LibraryManager.library = {
 
   memmove__sig: 'iiii',
   memmove__asm: true,
-  memmove__deps: ['memcpy'],
+  memmove__deps: ['memcpy', 'emscripten_memcpy_big'],
   memmove: function(dest, src, num) {
     dest = dest|0; src = src|0; num = num|0;
     var ret = 0;
     if (((src|0) < (dest|0)) & ((dest|0) < ((src + num)|0))) {
-      // Unlikely case: Copy backwards in a safe manner
+      // Unlikely case: Copy backwards in a safe manner. HEAPU8.set() copies as if through a temporary buffer when
+      // the source is a view of the same memory, so large overlapping moves can use it too.
+      if ((num|0) >=
+#if SIMD
+        196608
+#else
+        8192
+#endif
+      ) {
+        return _emscripten_memcpy_big(dest|0, src|0, num|0)|0;
+      }
       ret = dest;
       src = (src + num)|0;
       dest = (dest + num)|0;
+      if ((dest&3) == (src&3)) {
+        // The unaligned < 4-byte back, then words from the end down.
+        while (dest & 3) {
+          if ((num|0) == 0) return ret|0;
+          dest = (dest - 1)|0;
+          src = (src - 1)|0;
+          num = (num - 1)|0;
+          {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i8'), 'i8') }}};
+        }
+        while ((num|0) >= 16) {
+          dest = (dest - 16)|0;
+          src = (src - 16)|0;
+          num = (num - 16)|0;
+          {{{ makeSetValueAsm('dest', 12, makeGetValueAsm('src', 12, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 8, makeGetValueAsm('src', 8, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 4, makeGetValueAsm('src', 4, 'i32'), 'i32') }}};
+          {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i32'), 'i32') }}};
+        }
+        while ((num|0) >= 4) {
+          dest = (dest - 4)|0;
+          src = (src - 4)|0;
+          num = (num - 4)|0;
+          {{{ makeSetValueAsm('dest', 0, makeGetValueAsm('src', 0, 'i32'), 'i32') }}};
+        }
+      }
       while ((num|0) > 0) {
         dest = (dest - 1)|0;
         src = (src - 1)|0;
@@ -926,8 +1010,25 @@ LibraryManager.library = {
   memset__inline: function(ptr, value, num, align) {
     return makeSetValues(ptr, 0, value, 'null', num, align);
   },
+  emscripten_memset_big: function(ptr, value, num) {
+    if (HEAPU8.fill) {
+      HEAPU8.fill(value, ptr, ptr+num);
+    } else {
+      // Without TypedArray.fill, fill a little and then keep doubling the filled area.
+      var done = Math.min(num, 16);
+      for (var i = 0; i < done; i++) HEAPU8[ptr+i] = value;
+      while (done < num) {
+        var chunk = Math.min(done, num - done);
+        HEAPU8.set(HEAPU8.subarray(ptr, ptr+chunk), ptr+done);
+        done += chunk;
+      }
+    }
+    return ptr;
+  },
+
   memset__sig: 'iiii',
   memset__asm: true,
+  memset__deps: ['emscripten_memset_big'],
   memset: function(ptr, value, num) {
     ptr = ptr|0; value = value|0; num = num|0;
     var end = 0, aligned_end = 0, block_aligned_end = 0, value4 = 0;
@@ -937,7 +1038,17 @@ LibraryManager.library = {
     end = (ptr + num)|0;
 
     value = value & 0xff;
-    if ((num|0) >= 67 /* 64 bytes for an unrolled loop + 3 bytes for unaligned head*/) {
+    // Large fills are left to the typed array, with the same cutoff as memcpy uses for HEAPU8.set().
+    if ((num|0) >=
+#if SIMD
+      196608
+#else
+      8192
+#endif
+    ) {
+      return _emscripten_memset_big(ptr|0, value|0, num|0)|0;
+    }
+    if ((num|0) >= 8) {
       while ((ptr&3) != 0) {
         {{{ makeSetValueAsm('ptr', 0, 'value', 'i8') }}};
         ptr = (ptr+1)|0;
@@ -977,12 +1088,27 @@ LibraryManager.library = {
         ptr = (ptr + 64)|0;
       }
 
-      while ((ptr|0) < (aligned_end|0) ) {
-        {{{ makeSetValueAsm('ptr', 0, 'value4', 'i32') }}};
-        ptr = (ptr+4)|0;
+      // Less than 64 aligned bytes are left: jump straight into a run of word stores of the right length.
+      switch ((((aligned_end - ptr)|0) >> 2)|0) {
+        case 15: {{{ makeSetValueAsm('ptr', 56, 'value4', 'i32') }}};
+        case 14: {{{ makeSetValueAsm('ptr', 52, 'value4', 'i32') }}};
+        case 13: {{{ makeSetValueAsm('ptr', 48, 'value4', 'i32') }}};
+        case 12: {{{ makeSetValueAsm('ptr', 44, 'value4', 'i32') }}};
+        case 11: {{{ makeSetValueAsm('ptr', 40, 'value4', 'i32') }}};
+        case 10: {{{ makeSetValueAsm('ptr', 36, 'value4', 'i32') }}};
+        case 9: {{{ makeSetValueAsm('ptr', 32, 'value4', 'i32') }}};
+        case 8: {{{ makeSetValueAsm('ptr', 28, 'value4', 'i32') }}};
+        case 7: {{{ makeSetValueAsm('ptr', 24, 'value4', 'i32') }}};
+        case 6: {{{ makeSetValueAsm('ptr', 20, 'value4', 'i32') }}};
+        case 5: {{{ makeSetValueAsm('ptr', 16, 'value4', 'i32') }}};
+        case 4: {{{ makeSetValueAsm('ptr', 12, 'value4', 'i32') }}};
+        case 3: {{{ makeSetValueAsm('ptr', 8, 'value4', 'i32') }}};
+        case 2: {{{ makeSetValueAsm('ptr', 4, 'value4', 'i32') }}};
+        case 1: {{{ makeSetValueAsm('ptr', 0, 'value4', 'i32') }}};
       }
+      ptr = aligned_end;
     }
-    // The remaining bytes.
+    // The remaining bytes, or all of a small fill.
     while ((ptr|0) < (end|0)) {
       {{{ makeSetValueAsm('ptr', 0, 'value', 'i8') }}};
       ptr = (ptr+1)|0;
@@ -4193,6 +4319,42 @@ LibraryManager.library = {
     return bytesWrittenExcludingNull+1;
   },
 
+  // Function names seen in the call stacks of heap profiler samples, indexed by id - 1.
+  $heapProfilerSymbols: { names: [], ids: {} },
+
+  // Writes ids of the functions on the call stack of the allocation being sampled, innermost first, and returns
+  // how many were written. Frames of the allocator and the profiler itself are left out.
+  emscripten_heap_profiler_capture_stack__deps: ['$heapProfilerSymbols'],
+  emscripten_heap_profiler_capture_stack: function(frames, maxFrames) {
+    var lines = jsStackTrace().split('\n');
+    var allocatorRe = /heap_profiler|jsStackTrace|^_(dl)?(malloc|calloc|realloc|memalign|posix_memalign|valloc)$|^__Zn[wa]j/;
+    var chromeRe = /^\s*at (?:Object\.)?(\S+) /;
+    var firefoxRe = /^(?:Object\.)?([^@]*)@/;
+    var count = 0;
+    var inAllocator = true;
+    for (var i = 0; i < lines.length && count < maxFrames; i++) {
+      var parts = chromeRe.exec(lines[i]) || firefoxRe.exec(lines[i]);
+      if (!parts || !parts[1]) continue;
+      var name = parts[1];
+      if (inAllocator) {
+        if (allocatorRe.test(name)) continue;
+        inAllocator = false;
+      }
+      var id = heapProfilerSymbols.ids[name];
+      if (!id) {
+        id = heapProfilerSymbols.ids[name] = heapProfilerSymbols.names.push(name);
+      }
+      {{{ makeSetValue('frames', 'count * 4', 'id', 'i32') }}};
+      count++;
+    }
+    return count;
+  },
+
+  emscripten_heap_profiler_get_symbol__deps: ['$heapProfilerSymbols'],
+  emscripten_heap_profiler_get_symbol: function(id, out, maxbytes) {
+    return stringToUTF8(heapProfilerSymbols.names[id - 1] || '??', out, maxbytes);
+  },
+
   emscripten_log_js__deps: ['emscripten_get_callstack_js'],
   emscripten_log_js: function(flags, str) {
     if (flags & 24/*EM_LOG_C_STACK | EM_LOG_JS_STACK*/) {
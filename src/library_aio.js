@@ -0,0 +1,310 @@
+// POSIX asynchronous I/O (aio.h) over the FS layer.
+//
+// Requests queue up on the main thread and are carried out on later turns of
+// its event loop, a time slice at a time, so a program (or a pthread, whose
+// submissions are proxied here) can keep working while they run. Each request's
+// status and result are stored into its aiocb in linear memory as it completes,
+// so aio_error() and aio_return() are plain loads that never leave the calling
+// thread. aio_fsync() persists the file's mount with syncfs(), which for IDBFS
+// is itself asynchronous.
+
+mergeInto(LibraryManager.library, {
+  $AIO__deps: ['$FS', '$Browser', '$ERRNO_CODES'],
+  $AIO: {
+    // how long to spend running requests before yielding to the event loop
+    SLICE_MS: 8,
+
+    // submitted requests that have not started yet, oldest first
+    queue: [],
+    head: 0,
+    scheduled: false,
+
+    submit: function(aiocb, opcode, list) {
+      var fd = {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.aio_fildes, 'i32') }}};
+      if (!FS.getStream(fd)) {
+        throw new FS.ErrnoError(ERRNO_CODES.EBADF);
+      }
+      {{{ makeSetValue('aiocb', C_STRUCTS.aiocb.__ret, '0', 'i32') }}};
+      {{{ makeSetValue('aiocb', C_STRUCTS.aiocb.__err, 'ERRNO_CODES.EINPROGRESS', 'i32') }}};
+      var request = { aiocb: aiocb, opcode: opcode, list: list, canceled: false,
+                      notification: AIO.notification(aiocb + {{{ C_STRUCTS.aiocb.aio_sigevent }}}) };
+      if (list) list.remaining++;
+      AIO.queue.push(request);
+      AIO.schedule();
+    },
+    schedule: function() {
+      if (AIO.scheduled || AIO.head === AIO.queue.length) return;
+      AIO.scheduled = true;
+      Browser.safeSetTimeout(function() {
+        AIO.scheduled = false;
+        var end = Date.now() + AIO.SLICE_MS;
+        AIO.run(function() {
+          return Date.now() >= end;
+        });
+        AIO.schedule();
+      }, 0);
+    },
+    next: function() {
+      while (AIO.head < AIO.queue.length) {
+        var request = AIO.queue[AIO.head++];
+        if (AIO.head === AIO.queue.length) {
+          AIO.queue = [];
+          AIO.head = 0;
+        }
+        if (!request.canceled) return request;
+      }
+      return null;
+    },
+    // runs queued requests in order until there are none left or done() says to stop
+    run: function(done) {
+      var request;
+      while (!done() && (request = AIO.next())) {
+        AIO.perform(request);
+      }
+    },
+    perform: function(request) {
+      var aiocb = request.aiocb;
+      var fd = {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.aio_fildes, 'i32') }}};
+      var buf = {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.aio_buf, '*') }}};
+      var nbytes = {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.aio_nbytes, 'i32') }}};
+      var offset = {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.aio_offset, 'i32') }}};
+      try {
+        var stream = FS.getStream(fd);
+        if (!stream) throw new FS.ErrnoError(ERRNO_CODES.EBADF);
+        switch (request.opcode) {
+          case {{{ cDefine('LIO_READ') }}}:
+            var position = stream.seekable ? offset : undefined;
+            AIO.complete(request, FS.read(stream, {{{ heapAndOffset('HEAP8', 'buf') }}}, nbytes, position), 0);
+            return;
+          case {{{ cDefine('LIO_WRITE') }}}:
+            // appending writes go to the end, wherever aio_offset points
+            var position = stream.seekable && !(stream.flags & {{{ cDefine('O_APPEND') }}}) ? offset : undefined;
+            AIO.complete(request, FS.write(stream, {{{ heapAndOffset('HEAP8', 'buf') }}}, nbytes, position), 0);
+            return;
+          default: // fsync
+            var mount = stream.node.mount;
+            if (!mount.type.syncfs) {
+              // everything is already in memory, there's nothing more to persist
+              AIO.complete(request, 0, 0);
+              return;
+            }
+            mount.type.syncfs(mount, false, function(err) {
+              if (err) {
+                AIO.complete(request, -1, ERRNO_CODES.EIO);
+              } else {
+                AIO.complete(request, 0, 0);
+              }
+            });
+            return;
+        }
+      } catch (e) {
+        if (!(e instanceof FS.ErrnoError)) throw e;
+        AIO.complete(request, -1, e.errno);
+      }
+    },
+    complete: function(request, ret, err) {
+      var aiocb = request.aiocb;
+      {{{ makeSetValue('aiocb', C_STRUCTS.aiocb.__ret, 'ret', 'i32') }}};
+#if USE_PTHREADS
+      // publish the result before the status that says it's there
+      Atomics.store(HEAP32, (aiocb + {{{ C_STRUCTS.aiocb.__err }}}) >> 2, err);
+#else
+      {{{ makeSetValue('aiocb', C_STRUCTS.aiocb.__err, 'err', 'i32') }}};
+#endif
+      AIO.notify(request.notification);
+      var list = request.list;
+      if (list) {
+        if (err) list.failed = true;
+        if (!--list.remaining) AIO.notify(list.notification);
+      }
+    },
+    // signals are not delivered, so of the notification methods this only honors
+    // SIGEV_THREAD, whose function is called on the main thread. The sigevent is
+    // read at submission, as the caller need not keep it around after that.
+    notification: function(sigevent) {
+      if (!sigevent || {{{ makeGetValue('sigevent', C_STRUCTS.sigevent.sigev_notify, 'i32') }}} !== {{{ cDefine('SIGEV_THREAD') }}}) return null;
+      return {
+        func: {{{ makeGetValue('sigevent', C_STRUCTS.sigevent.sigev_notify_function, '*') }}},
+        value: {{{ makeGetValue('sigevent', C_STRUCTS.sigevent.sigev_value, 'i32') }}}
+      };
+    },
+    notify: function(notification) {
+      if (!notification) return;
+      // union sigval is passed by value, which means as a pointer to a copy of it
+      var stack = stackSave();
+      var value = stackAlloc(4);
+      {{{ makeSetValue('value', 0, 'notification.value', 'i32') }}};
+      Module['dynCall_vi'](notification.func, value);
+      stackRestore(stack);
+    },
+    find: function(aiocb) {
+      for (var i = AIO.head; i < AIO.queue.length; i++) {
+        var request = AIO.queue[i];
+        if (request.aiocb === aiocb && !request.canceled) return request;
+      }
+      return null;
+    },
+    inProgress: function(aiocb) {
+#if USE_PTHREADS
+      return Atomics.load(HEAP32, (aiocb + {{{ C_STRUCTS.aiocb.__err }}}) >> 2) === ERRNO_CODES.EINPROGRESS;
+#else
+      return {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.__err, 'i32') }}} === ERRNO_CODES.EINPROGRESS;
+#endif
+    }
+  },
+
+  aio_read__deps: ['$AIO', '__setErrNo'],
+  aio_read__proxy: 'sync',
+  aio_read__sig: 'ii',
+  aio_read: function(aiocb) {
+    try {
+      AIO.submit(aiocb, {{{ cDefine('LIO_READ') }}}, null);
+      return 0;
+    } catch (e) {
+      if (!(e instanceof FS.ErrnoError)) throw e;
+      ___setErrNo(e.errno);
+      return -1;
+    }
+  },
+
+  aio_write__deps: ['$AIO', '__setErrNo'],
+  aio_write__proxy: 'sync',
+  aio_write__sig: 'ii',
+  aio_write: function(aiocb) {
+    try {
+      AIO.submit(aiocb, {{{ cDefine('LIO_WRITE') }}}, null);
+      return 0;
+    } catch (e) {
+      if (!(e instanceof FS.ErrnoError)) throw e;
+      ___setErrNo(e.errno);
+      return -1;
+    }
+  },
+
+  aio_fsync__deps: ['$AIO', '__setErrNo'],
+  aio_fsync__proxy: 'sync',
+  aio_fsync__sig: 'iii',
+  aio_fsync: function(op, aiocb) {
+    if (op !== {{{ cDefine('O_SYNC') }}} && op !== {{{ cDefine('O_DSYNC') }}}) {
+      ___setErrNo(ERRNO_CODES.EINVAL);
+      return -1;
+    }
+    try {
+      AIO.submit(aiocb, -1, null);
+      return 0;
+    } catch (e) {
+      if (!(e instanceof FS.ErrnoError)) throw e;
+      ___setErrNo(e.errno);
+      return -1;
+    }
+  },
+
+  // Callable in pthread without __proxy needed.
+  aio_error: function(aiocb) {
+#if USE_PTHREADS
+    return Atomics.load(HEAP32, (aiocb + {{{ C_STRUCTS.aiocb.__err }}}) >> 2);
+#else
+    return {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.__err, 'i32') }}};
+#endif
+  },
+
+  // Callable in pthread without __proxy needed.
+  aio_return__deps: ['aio_error'],
+  aio_return: function(aiocb) {
+    _aio_error(aiocb); // orders the load below after the status
+    return {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.__ret, 'i32') }}};
+  },
+
+  aio_cancel__deps: ['$AIO', '__setErrNo'],
+  aio_cancel__proxy: 'sync',
+  aio_cancel__sig: 'iii',
+  aio_cancel: function(fd, aiocb) {
+    if (!FS.getStream(fd)) {
+      ___setErrNo(ERRNO_CODES.EBADF);
+      return -1;
+    }
+    if (aiocb && {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.aio_fildes, 'i32') }}} !== fd) {
+      ___setErrNo(ERRNO_CODES.EINVAL);
+      return -1;
+    }
+    // only requests that have not started are still in the queue, and those can always be canceled
+    var canceled = false;
+    for (var i = AIO.head; i < AIO.queue.length; i++) {
+      var request = AIO.queue[i];
+      if (request.canceled || (aiocb ? request.aiocb !== aiocb : {{{ makeGetValue('request.aiocb', C_STRUCTS.aiocb.aio_fildes, 'i32') }}} !== fd)) continue;
+      request.canceled = true;
+      canceled = true;
+      AIO.complete(request, -1, ERRNO_CODES.ECANCELED);
+    }
+    if (canceled) return {{{ cDefine('AIO_CANCELED') }}};
+    // an fsync waiting on its mount can't be called back
+    if (aiocb && AIO.inProgress(aiocb)) return {{{ cDefine('AIO_NOTCANCELED') }}};
+    return {{{ cDefine('AIO_ALLDONE') }}};
+  },
+
+  // Nothing can block here, but reads and writes never need to: any still queued
+  // are carried out right away, in order, until one of the list completes. Only
+  // waiting on an fsync can time out.
+  aio_suspend__deps: ['$AIO', '__setErrNo'],
+  aio_suspend__proxy: 'sync',
+  aio_suspend__sig: 'iiii',
+  aio_suspend: function(list, nent, timeout) {
+    function anyDone() {
+      for (var i = 0; i < nent; i++) {
+        var aiocb = {{{ makeGetValue('list', 'i*4', '*') }}};
+        if (aiocb && !AIO.inProgress(aiocb)) return true;
+      }
+      return false;
+    }
+    function anyQueued() {
+      for (var i = 0; i < nent; i++) {
+        var aiocb = {{{ makeGetValue('list', 'i*4', '*') }}};
+        if (aiocb && AIO.find(aiocb)) return true;
+      }
+      return false;
+    }
+    if (!anyDone() && anyQueued()) {
+      AIO.run(anyDone);
+    }
+    if (anyDone()) return 0;
+    ___setErrNo(ERRNO_CODES.EAGAIN);
+    return -1;
+  },
+
+  lio_listio__deps: ['$AIO', '__setErrNo'],
+  lio_listio__proxy: 'sync',
+  lio_listio__sig: 'iiiii',
+  lio_listio: function(mode, list, nent, sigevent) {
+    if ((mode !== {{{ cDefine('LIO_WAIT') }}} && mode !== {{{ cDefine('LIO_NOWAIT') }}}) || nent < 0) {
+      ___setErrNo(ERRNO_CODES.EINVAL);
+      return -1;
+    }
+    var group = { remaining: 0, failed: false, notification: mode === {{{ cDefine('LIO_NOWAIT') }}} ? AIO.notification(sigevent) : null };
+    for (var i = 0; i < nent; i++) {
+      var aiocb = {{{ makeGetValue('list', 'i*4', '*') }}};
+      if (!aiocb) continue;
+      var opcode = {{{ makeGetValue('aiocb', C_STRUCTS.aiocb.aio_lio_opcode, 'i32') }}};
+      if (opcode !== {{{ cDefine('LIO_READ') }}} && opcode !== {{{ cDefine('LIO_WRITE') }}}) continue;
+      try {
+        AIO.submit(aiocb, opcode, group);
+      } catch (e) {
+        if (!(e instanceof FS.ErrnoError)) throw e;
+        {{{ makeSetValue('aiocb', C_STRUCTS.aiocb.__ret, '-1', 'i32') }}};
+        {{{ makeSetValue('aiocb', C_STRUCTS.aiocb.__err, 'e.errno', 'i32') }}};
+        group.failed = true;
+      }
+    }
+    if (mode === {{{ cDefine('LIO_WAIT') }}}) {
+      AIO.run(function() {
+        return !group.remaining;
+      });
+    } else if (!group.remaining) {
+      AIO.notify(group.notification);
+    }
+    if (group.failed) {
+      ___setErrNo(ERRNO_CODES.EIO);
+      return -1;
+    }
+    return 0;
+  },
+});
@@ -951,7 +951,7 @@ var LibraryBrowser = {
     FS.createPreloadedFile(
       PATH.dirname(_file),
       PATH.basename(_file),
-      new Uint8Array(data.object.contents), true, true,
+      MEMFS.getFileDataAsTypedArray(data.object), true, true,
       function() {
         if (onload) Module['dynCall_vi'](onload, file);
       },
@@ -3,10 +3,10 @@
 var LibraryFetch = {
 #if USE_PTHREADS
   $Fetch__postset: 'if (!ENVIRONMENT_IS_PTHREAD) Fetch.staticInit();',
-  fetch_work_queue: '; if (ENVIRONMENT_IS_PTHREAD) _fetch_work_queue = PthreadWorkerInit._fetch_work_queue; else PthreadWorkerInit._fetch_work_queue = _fetch_work_queue = allocate(12, "i32*", ALLOC_STATIC)',
+  fetch_work_queue: '; if (ENVIRONMENT_IS_PTHREAD) _fetch_work_queue = PthreadWorkerInit._fetch_work_queue; else PthreadWorkerInit._fetch_work_queue = _fetch_work_queue = allocate(56 /*sizeof(__emscripten_fetch_queue)*/, "i32*", ALLOC_STATIC)',
 #else
   $Fetch__postset: 'Fetch.staticInit();',
-  fetch_work_queue: 'allocate(12, "i32*", ALLOC_STATIC)',
+  fetch_work_queue: 'allocate(56 /*sizeof(__emscripten_fetch_queue)*/, "i32*", ALLOC_STATIC)',
 #endif
   $Fetch: Fetch,
   _emscripten_get_fetch_work_queue__deps: ['fetch_work_queue'],
@@ -26,6 +26,12 @@ mergeInto(LibraryManager.library, {
     streams: [],
     nextInode: 1,
     nameTable: null,
+    nameTableSize: 0, // the number of nodes in the name table
+    // Resolved absolute paths, so that repeated lookups of a path or of paths in the same directory need not walk
+    // every component again. Any change to the namespace clears it.
+    pathCache: {},
+    pathCacheSize: 0,
+    pathCacheMaxSize: 16384,
     currentPath: '/',
     initialized: false,
     // Whether we are currently ignoring permissions. Useful when preparing the
@@ -81,9 +87,29 @@ mergeInto(LibraryManager.library, {
       // start at the root
       var current = FS.root;
       var current_path = '/';
+      var i = 0;
+
+      // Everything but the last component is always resolved following links and mounts, so the parent directory
+      // can come from the cache whatever the options; so can the whole path when following both.
+      var parent_key = '/' + parts.slice(0, -1).join('/');
+      var path_key = (parts.length && opts.follow && opts.follow_mount && !opts.parent) ? '/' + parts.join('/') : null;
+      if (path_key !== null && FS.pathCache[path_key]) {
+        return { path: FS.pathCache[path_key].path, node: FS.pathCache[path_key].node };
+      }
+      if (parts.length > 1 && FS.pathCache[parent_key]) {
+        if (opts.parent) {
+          return { path: FS.pathCache[parent_key].path, node: FS.pathCache[parent_key].node };
+        }
+        current = FS.pathCache[parent_key].node;
+        current_path = FS.pathCache[parent_key].path;
+        i = parts.length-1;
+      }
 
-      for (var i = 0; i < parts.length; i++) {
+      for (; i < parts.length; i++) {
         var islast = (i === parts.length-1);
+        if (islast && parts.length > 1) {
+          FS.cachePath(parent_key, current_path, current);
+        }
         if (islast && opts.parent) {
           // stop resolving
           break;
@@ -117,8 +143,27 @@ mergeInto(LibraryManager.library, {
         }
       }
 
+      if (path_key !== null) {
+        FS.cachePath(path_key, current_path, current);
+      }
       return { path: current_path, node: current };
     },
+    cachePath: function(key, path, node) {
+      // Lookups done while permissions are ignored may have gone through directories that would otherwise refuse
+      // them, so only cache those done with permissions.
+      if (FS.ignorePermissions || FS.pathCache[key]) return;
+      if (FS.pathCacheSize >= FS.pathCacheMaxSize) {
+        FS.clearPathCache();
+      }
+      FS.pathCache[key] = { path: path, node: node };
+      FS.pathCacheSize++;
+    },
+    clearPathCache: function() {
+      if (FS.pathCacheSize) {
+        FS.pathCache = {};
+        FS.pathCacheSize = 0;
+      }
+    },
     getPath: function(node) {
       var path;
       while (true) {
@@ -148,25 +193,48 @@ mergeInto(LibraryManager.library, {
       return ((parentid + hash) >>> 0) % FS.nameTable.length;
     },
     hashAddNode: function(node) {
+      // Keep the chains short by doubling the table whenever it holds more nodes than buckets.
+      if (FS.nameTableSize >= FS.nameTable.length) {
+        FS.resizeNameTable(FS.nameTable.length * 2);
+      }
       var hash = FS.hashName(node.parent.id, node.name);
       node.name_next = FS.nameTable[hash];
       FS.nameTable[hash] = node;
+      FS.nameTableSize++;
     },
     hashRemoveNode: function(node) {
+      // Removing a node changes what paths resolve to.
+      FS.clearPathCache();
       var hash = FS.hashName(node.parent.id, node.name);
       if (FS.nameTable[hash] === node) {
         FS.nameTable[hash] = node.name_next;
+        FS.nameTableSize--;
       } else {
         var current = FS.nameTable[hash];
         while (current) {
           if (current.name_next === node) {
             current.name_next = node.name_next;
+            FS.nameTableSize--;
             break;
           }
           current = current.name_next;
         }
       }
     },
+    resizeNameTable: function(length) {
+      var old = FS.nameTable;
+      FS.nameTable = new Array(length);
+      for (var i = 0; i < old.length; i++) {
+        var node = old[i];
+        while (node) {
+          var next = node.name_next;
+          var hash = FS.hashName(node.parent.id, node.name);
+          node.name_next = FS.nameTable[hash];
+          FS.nameTable[hash] = node;
+          node = next;
+        }
+      }
+    },
     lookupNode: function(parent, name) {
       var err = FS.mayLookup(parent);
       if (err) {
@@ -548,6 +616,8 @@ mergeInto(LibraryManager.library, {
         }
       }
 
+      FS.clearPathCache();
+
       var mount = {
         type: type,
         opts: opts,
@@ -602,6 +672,7 @@ mergeInto(LibraryManager.library, {
 
       // no longer a mountpoint
       node.mounted = null;
+      FS.clearPathCache();
 
       // remove this mount from the child mounts
       var idx = node.mount.mounts.indexOf(mount);
@@ -888,6 +959,10 @@ mergeInto(LibraryManager.library, {
         mode: (mode & {{{ cDefine('S_IALLUGO') }}}) | (node.mode & ~{{{ cDefine('S_IALLUGO') }}}),
         timestamp: Date.now()
       });
+      if (FS.isDir(node.mode)) {
+        // lookups through the directory may now be refused
+        FS.clearPathCache();
+      }
     },
     lchmod: function(path, mode) {
       FS.chmod(path, mode, true);
@@ -1384,6 +1459,7 @@ mergeInto(LibraryManager.library, {
       FS.ensureErrnoError();
 
       FS.nameTable = new Array(4096);
+      FS.nameTableSize = 0;
 
       FS.mount(MEMFS, {}, '/');
 
@@ -1868,7 +1944,7 @@ mergeInto(LibraryManager.library, {
           if (fail == 0) onload(); else onerror();
         }
         paths.forEach(function(path) {
-          var putRequest = files.put(FS.analyzePath(path).object.contents, path);
+          var putRequest = files.put(MEMFS.getFileDataAsTypedArray(FS.analyzePath(path).object), path);
           putRequest.onsuccess = function putRequest_onsuccess() { ok++; if (ok + fail == total) finish() };
           putRequest.onerror = function putRequest_onerror() { fail++; if (ok + fail == total) finish() };
         });
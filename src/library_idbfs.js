@@ -11,21 +11,203 @@ mergeInto(LibraryManager.library, {
     },
     DB_VERSION: 21,
     DB_STORE_NAME: 'FILE_DATA',
+    ops_table: null,
+    // Set while a sync changes the local tree, so that those changes are not journaled.
+    suppressJournal: false,
     mount: function(mount) {
-      // reuse all of the core MEMFS functionality
-      return MEMFS.mount.apply(null, arguments);
+      // reuse all of the core MEMFS functionality, with the operations that change the tree wrapped to journal the
+      // paths they touch
+      var root = IDBFS.trackNode(MEMFS.mount.apply(null, arguments));
+      // Paths changed since the last sync to IndexedDB. Until a first full sync has reconciled the tree with the
+      // database, there is no baseline to apply them to.
+      mount.journal = { changed: {}, baseline: false };
+      return root;
+    },
+    trackNode: function(node) {
+      if (!IDBFS.ops_table) {
+        var wrap = function(ops, wrappers) {
+          var ret = {};
+          for (var key in ops) ret[key] = wrappers[key] || ops[key];
+          return ret;
+        };
+        var setattr = function(node, attr) {
+          MEMFS.node_ops.setattr(node, attr);
+          IDBFS.journalNode(node);
+        };
+        IDBFS.ops_table = {
+          dir: {
+            node: wrap(MEMFS.ops_table.dir.node, {
+              setattr: setattr,
+              mknod: function(parent, name, mode, dev) {
+                var node = IDBFS.trackNode(MEMFS.node_ops.mknod(parent, name, mode, dev));
+                IDBFS.journalNode(node);
+                IDBFS.journalDir(parent);
+                return node;
+              },
+              symlink: function(parent, newname, oldpath) {
+                var node = MEMFS.node_ops.symlink(parent, newname, oldpath);
+                IDBFS.journalNode(node);
+                IDBFS.journalDir(parent);
+                return node;
+              },
+              rename: function(old_node, new_dir, new_name) {
+                // everything below a renamed directory moves too
+                IDBFS.journalTree(old_node);
+                IDBFS.journalDir(old_node.parent);
+                MEMFS.node_ops.rename(old_node, new_dir, new_name);
+                IDBFS.journalTree(old_node);
+                IDBFS.journalDir(new_dir);
+              },
+              unlink: function(parent, name) {
+                MEMFS.node_ops.unlink(parent, name);
+                IDBFS.journalPath(parent.mount, PATH.join2(FS.getPath(parent), name));
+                IDBFS.journalDir(parent);
+              },
+              rmdir: function(parent, name) {
+                MEMFS.node_ops.rmdir(parent, name);
+                IDBFS.journalPath(parent.mount, PATH.join2(FS.getPath(parent), name));
+                IDBFS.journalDir(parent);
+              }
+            }),
+            stream: MEMFS.ops_table.dir.stream
+          },
+          file: {
+            node: wrap(MEMFS.ops_table.file.node, {
+              setattr: setattr
+            }),
+            stream: wrap(MEMFS.ops_table.file.stream, {
+              write: function(stream, buffer, offset, length, position, canOwn) {
+                IDBFS.journalNode(stream.node);
+                return MEMFS.stream_ops.write(stream, buffer, offset, length, position, canOwn);
+              },
+              allocate: function(stream, offset, length) {
+                IDBFS.journalNode(stream.node);
+                return MEMFS.stream_ops.allocate(stream, offset, length);
+              },
+              msync: function(stream, buffer, offset, length, mmapFlags) {
+                IDBFS.journalNode(stream.node);
+                return MEMFS.stream_ops.msync(stream, buffer, offset, length, mmapFlags);
+              }
+            })
+          }
+        };
+      }
+      // links and devices keep the MEMFS operations; creating and removing them is journaled by their directory
+      if (FS.isDir(node.mode)) {
+        node.node_ops = IDBFS.ops_table.dir.node;
+        node.stream_ops = IDBFS.ops_table.dir.stream;
+      } else if (FS.isFile(node.mode)) {
+        node.node_ops = IDBFS.ops_table.file.node;
+        node.stream_ops = IDBFS.ops_table.file.stream;
+      }
+      return node;
+    },
+    journalPath: function(mount, path) {
+      if (mount.journal && !IDBFS.suppressJournal) {
+        mount.journal.changed[path] = true;
+      }
+    },
+    journalNode: function(node) {
+      IDBFS.journalPath(node.mount, FS.getPath(node));
+    },
+    // A directory whose entries changed is stored again too, so that its timestamp stays current. The mount root
+    // has no entry of its own.
+    journalDir: function(node) {
+      if (node !== node.mount.root) IDBFS.journalNode(node);
+    },
+    journalTree: function(node) {
+      IDBFS.journalNode(node);
+      if (FS.isDir(node.mode)) {
+        for (var name in node.contents) {
+          IDBFS.journalTree(node.contents[name]);
+        }
+      }
     },
     syncfs: function(mount, populate, callback) {
+      var journal = mount.journal;
+      if (!populate && journal.baseline) {
+        return IDBFS.syncJournal(mount, callback);
+      }
+
+      // A full sync. When storing, everything changed so far is about to be stored, so start a new journal now;
+      // changes made while the sync is in flight go to the new one.
+      var changed = journal.changed;
+      if (!populate) journal.changed = {};
+      function done(err) {
+        if (err) {
+          if (!populate) IDBFS.mergeJournal(journal, changed);
+        } else {
+          journal.baseline = true;
+        }
+        callback(err);
+      }
+
       IDBFS.getLocalSet(mount, function(err, local) {
-        if (err) return callback(err);
+        if (err) return done(err);
 
         IDBFS.getRemoteSet(mount, function(err, remote) {
-          if (err) return callback(err);
+          if (err) return done(err);
 
           var src = populate ? remote : local;
           var dst = populate ? local : remote;
 
-          IDBFS.reconcile(src, dst, callback);
+          IDBFS.reconcile(src, dst, done);
+        });
+      });
+    },
+    mergeJournal: function(journal, changed) {
+      for (var path in changed) {
+        journal.changed[path] = true;
+      }
+    },
+    // Stores just the journaled paths, in a single transaction: those that still exist are written, the others are
+    // deleted.
+    syncJournal: function(mount, callback) {
+      var journal = mount.journal;
+      var changed = journal.changed;
+      var paths = Object.keys(changed);
+      if (!paths.length) {
+        return callback(null);
+      }
+      journal.changed = {};
+
+      var completed = 0;
+      var errored = false;
+      function done(err) {
+        if (errored) return;
+        if (err) {
+          errored = true;
+          IDBFS.mergeJournal(journal, changed);
+          return callback(err);
+        }
+        if (++completed >= paths.length) {
+          return callback(null);
+        }
+      };
+
+      IDBFS.getDB(mount.mountpoint, function(err, db) {
+        if (err) return done(err);
+
+        try {
+          var transaction = db.transaction([IDBFS.DB_STORE_NAME], 'readwrite');
+          var store = transaction.objectStore(IDBFS.DB_STORE_NAME);
+        } catch (e) {
+          return done(e);
+        }
+        transaction.onerror = function(e) {
+          done(this.error);
+          e.preventDefault();
+        };
+
+        paths.sort().forEach(function(path) {
+          if (FS.analyzePath(path).exists) {
+            IDBFS.loadLocalEntry(path, function(err, entry) {
+              if (err) return done(err);
+              IDBFS.storeRemoteEntry(store, path, entry, done);
+            });
+          } else {
+            IDBFS.removeRemoteEntry(store, path, done);
+          }
         });
       });
     },
@@ -154,31 +336,37 @@ mergeInto(LibraryManager.library, {
       } else if (FS.isFile(stat.mode)) {
         // Performance consideration: storing a normal JavaScript array to a IndexedDB is much slower than storing a typed array.
         // Therefore always convert the file contents to a typed array first before writing the data to IndexedDB.
-        node.contents = MEMFS.getFileDataAsTypedArray(node);
-        return callback(null, { timestamp: stat.mtime, mode: stat.mode, contents: node.contents });
+        var contents = MEMFS.getFileDataAsTypedArray(node);
+        if (!node.chunks) node.contents = contents; // Chunked files keep their chunks; the typed array is a copy.
+        return callback(null, { timestamp: stat.mtime, mode: stat.mode, contents: contents });
       } else {
         return callback(new Error('node type not supported'));
       }
     },
     storeLocalEntry: function(path, entry, callback) {
+      if (!FS.isDir(entry.mode) && !FS.isFile(entry.mode)) {
+        return callback(new Error('node type not supported'));
+      }
+
+      IDBFS.suppressJournal = true;
       try {
         if (FS.isDir(entry.mode)) {
           FS.mkdir(path, entry.mode);
-        } else if (FS.isFile(entry.mode)) {
-          FS.writeFile(path, entry.contents, { canOwn: true });
         } else {
-          return callback(new Error('node type not supported'));
+          FS.writeFile(path, entry.contents, { canOwn: true });
         }
 
         FS.chmod(path, entry.mode);
         FS.utime(path, entry.timestamp, entry.timestamp);
       } catch (e) {
-        return callback(e);
+        var error = e;
       }
+      IDBFS.suppressJournal = false;
 
-      callback(null);
+      callback(error || null);
     },
     removeLocalEntry: function(path, callback) {
+      IDBFS.suppressJournal = true;
       try {
         var lookup = FS.lookupPath(path);
         var stat = FS.stat(path);
@@ -189,10 +377,11 @@ mergeInto(LibraryManager.library, {
           FS.unlink(path);
         }
       } catch (e) {
-        return callback(e);
+        var error = e;
       }
+      IDBFS.suppressJournal = false;
 
-      callback(null);
+      callback(error || null);
     },
     loadRemoteEntry: function(store, path, callback) {
       var req = store.get(path);
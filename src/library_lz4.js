@@ -5,6 +5,7 @@ mergeInto(LibraryManager.library, {
     DIR_MODE: {{{ cDefine('S_IFDIR') }}} | 511 /* 0777 */,
     FILE_MODE: {{{ cDefine('S_IFREG') }}} | 511 /* 0777 */,
     CHUNK_SIZE: -1,
+    CACHE_SLOTS: -1,
     codec: null,
     init: function() {
       if (LZ4.codec) return;
@@ -13,17 +14,29 @@ mergeInto(LibraryManager.library, {
         return MiniLZ4;
       })();
       LZ4.CHUNK_SIZE = LZ4.codec.CHUNK_SIZE;
+      LZ4.CACHE_SLOTS = Math.max(2, Math.floor({{{ LZ4_CACHE_SIZE }}} / LZ4.CHUNK_SIZE));
     },
     loadPackage: function (pack) {
       LZ4.init();
       var compressedData = pack['compressedData'];
       if (!compressedData) compressedData = LZ4.codec.compressPackage(pack['data']);
-      assert(compressedData.cachedIndexes.length === compressedData.cachedChunks.length);
-      for (var i = 0; i < compressedData.cachedIndexes.length; i++) {
+      // decompressed chunks are kept in an LRU cache of LZ4_CACHE_SIZE bytes. the package has room for two of them
+      // after the compressed data, a larger cache gets its own buffer.
+      var slots = LZ4.CACHE_SLOTS;
+      var cache = slots > 2 ? new Uint8Array(slots * LZ4.CHUNK_SIZE) : compressedData.data.subarray(compressedData.cachedOffset);
+      compressedData.cachedIndexes = []; // cache slot => chunk index, or -1
+      compressedData.cachedChunks = []; // cache slot => decompressed data
+      compressedData.cachedSlots = {}; // chunk index => cache slot
+      compressedData.newer = new Int32Array(slots); // cache slot => next more recently used slot, or -1
+      compressedData.older = new Int32Array(slots); // cache slot => next less recently used slot, or -1
+      compressedData.newest = 0;
+      compressedData.oldest = slots - 1;
+      for (var i = 0; i < slots; i++) {
         compressedData.cachedIndexes[i] = -1;
-        compressedData.cachedChunks[i] = compressedData.data.subarray(compressedData.cachedOffset + i*LZ4.CHUNK_SIZE,
-                                                                      compressedData.cachedOffset + (i+1)*LZ4.CHUNK_SIZE);
+        compressedData.cachedChunks[i] = cache.subarray(i*LZ4.CHUNK_SIZE, (i+1)*LZ4.CHUNK_SIZE);
         assert(compressedData.cachedChunks[i].length === LZ4.CHUNK_SIZE);
+        compressedData.newer[i] = i - 1;
+        compressedData.older[i] = i < slots - 1 ? i + 1 : -1;
       }
       pack['metadata'].files.forEach(function(file) {
         var dir = PATH.dirname(file.filename);
@@ -37,6 +50,31 @@ mergeInto(LibraryManager.library, {
         });
       });
     },
+    touchCachedChunk: function(compressedData, slot) {
+      // make the slot the most recently used one
+      if (slot === compressedData.newest) return;
+      var newer = compressedData.newer[slot], older = compressedData.older[slot];
+      compressedData.older[newer] = older;
+      if (older >= 0) {
+        compressedData.newer[older] = newer;
+      } else {
+        compressedData.oldest = newer;
+      }
+      compressedData.newer[slot] = -1;
+      compressedData.older[slot] = compressedData.newest;
+      compressedData.newer[compressedData.newest] = slot;
+      compressedData.newest = slot;
+    },
+    decompressChunk: function(compressedData, chunkIndex, output) {
+      if (compressedData.debug) {
+        console.log('decompressing chunk ' + chunkIndex);
+        Module['decompressedChunks'] = (Module['decompressedChunks'] || 0) + 1;
+      }
+      var compressedStart = compressedData.offsets[chunkIndex];
+      var compressed = compressedData.data.subarray(compressedStart, compressedStart + compressedData.sizes[chunkIndex]);
+      var originalSize = LZ4.codec.uncompress(compressed, output);
+      if (chunkIndex < compressedData.successes.length-1) assert(originalSize === LZ4.CHUNK_SIZE); // all but the last chunk must be full-size
+    },
     createNode: function (parent, name, mode, dev, contents, mtime) {
       var node = FS.createNode(parent, name, mode);
       node.mode = mode;
@@ -112,6 +150,11 @@ mergeInto(LibraryManager.library, {
         //console.log('LZ4 read ' + [offset, length, position]);
         length = Math.min(length, stream.node.size - position);
         if (length <= 0) return 0;
+        // a stream that carries on where its last read ended is being read through, and will not come back to the
+        // chunks it passes. those take the least recently used cache slot and stay there, so that streaming through a
+        // large file does not evict the chunks other reads keep coming back to.
+        var sequential = stream.lz4Next === position;
+        stream.lz4Next = position + length;
         var contents = stream.node.contents;
         var compressedData = contents.compressedData;
         var written = 0;
@@ -120,35 +163,33 @@ mergeInto(LibraryManager.library, {
           var desired = length - written;
           //console.log('current read: ' + ['start', start, 'desired', desired]);
           var chunkIndex = Math.floor(start / LZ4.CHUNK_SIZE);
-          var compressedStart = compressedData.offsets[chunkIndex];
-          var compressedSize = compressedData.sizes[chunkIndex];
+          var startInChunk = start % LZ4.CHUNK_SIZE;
+          var endInChunk = Math.min(startInChunk + desired, LZ4.CHUNK_SIZE);
           var currChunk;
           if (compressedData.successes[chunkIndex]) {
-            var found = compressedData.cachedIndexes.indexOf(chunkIndex);
-            if (found >= 0) {
+            var found = compressedData.cachedSlots[chunkIndex];
+            if (found !== undefined) {
               currChunk = compressedData.cachedChunks[found];
+              if (!sequential) LZ4.touchCachedChunk(compressedData, found);
+            } else if (startInChunk === 0 && endInChunk === LZ4.CHUNK_SIZE) {
+              // the whole chunk is wanted, decompress it right into the output without going through the cache
+              LZ4.decompressChunk(compressedData, chunkIndex, buffer.subarray(offset + written, offset + written + LZ4.CHUNK_SIZE));
+              written += LZ4.CHUNK_SIZE;
+              continue;
             } else {
-              // decompress the chunk
-              compressedData.cachedIndexes.pop();
-              compressedData.cachedIndexes.unshift(chunkIndex);
-              currChunk = compressedData.cachedChunks.pop();
-              compressedData.cachedChunks.unshift(currChunk);
-              if (compressedData.debug) {
-                console.log('decompressing chunk ' + chunkIndex);
-                Module['decompressedChunks'] = (Module['decompressedChunks'] || 0) + 1;
-              }
-              var compressed = compressedData.data.subarray(compressedStart, compressedStart + compressedSize);
-              //var t = Date.now();
-              var originalSize = LZ4.codec.uncompress(compressed, currChunk);
-              //console.log('decompress time: ' + (Date.now() - t));
-              if (chunkIndex < compressedData.successes.length-1) assert(originalSize === LZ4.CHUNK_SIZE); // all but the last chunk must be full-size
+              var slot = compressedData.oldest;
+              if (compressedData.cachedIndexes[slot] >= 0) delete compressedData.cachedSlots[compressedData.cachedIndexes[slot]];
+              compressedData.cachedIndexes[slot] = chunkIndex;
+              compressedData.cachedSlots[chunkIndex] = slot;
+              if (!sequential) LZ4.touchCachedChunk(compressedData, slot);
+              currChunk = compressedData.cachedChunks[slot];
+              LZ4.decompressChunk(compressedData, chunkIndex, currChunk);
             }
           } else {
             // uncompressed
+            var compressedStart = compressedData.offsets[chunkIndex];
             currChunk = compressedData.data.subarray(compressedStart, compressedStart + LZ4.CHUNK_SIZE);
           }
-          var startInChunk = start % LZ4.CHUNK_SIZE;
-          var endInChunk = Math.min(startInChunk + desired, LZ4.CHUNK_SIZE);
           buffer.set(currChunk.subarray(startInChunk, endInChunk), offset + written);
           var currWritten = endInChunk - startInChunk;
           written += currWritten;
@@ -89,6 +89,9 @@ mergeInto(LibraryManager.library, {
 
     // Given a file node, returns its file data converted to a regular JS array. You should treat this as read-only.
     getFileDataAsRegularArray: function(node) {
+#if MEMFS_CHUNK_SIZE
+      if (node.chunks) return Array.prototype.slice.call(MEMFS.getFileDataAsTypedArray(node));
+#endif
       if (node.contents && node.contents.subarray) {
         var arr = [];
         for (var i = 0; i < node.usedBytes; ++i) arr.push(node.contents[i]);
@@ -99,6 +102,13 @@ mergeInto(LibraryManager.library, {
 
     // Given a file node, returns its file data converted to a typed array.
     getFileDataAsTypedArray: function(node) {
+#if MEMFS_CHUNK_SIZE
+      if (node.chunks) { // Gather the chunks into a new contiguous array.
+        var data = new Uint8Array(node.usedBytes);
+        MEMFS.readChunks(node, data, 0, node.usedBytes, 0);
+        return data;
+      }
+#endif
       if (!node.contents) return new Uint8Array;
       if (node.contents.subarray) return node.contents.subarray(0, node.usedBytes); // Make sure to not return excess unused bytes.
       return new Uint8Array(node.contents);
@@ -108,6 +118,14 @@ mergeInto(LibraryManager.library, {
     // May allocate more, to provide automatic geometric increase and amortized linear performance appending writes.
     // Never shrinks the storage.
     expandFileStorage: function(node, newCapacity) {
+#if MEMFS_CHUNK_SIZE
+      // Files that outgrow a single chunk switch to chunked storage, which grows by adding chunks at the end.
+      if (node.chunks || newCapacity > {{{ MEMFS_CHUNK_SIZE }}}) {
+        if (!node.chunks) MEMFS.convertToChunks(node);
+        while (node.chunks.length * {{{ MEMFS_CHUNK_SIZE }}} < newCapacity) node.chunks.push(new Uint8Array({{{ MEMFS_CHUNK_SIZE }}}));
+        return;
+      }
+#endif
 #if !MEMFS_APPEND_TO_TYPED_ARRAYS
       // If we are asked to expand the size of a file that already exists, revert to using a standard JS array to store the file
       // instead of a typed array. This makes resizing the array more flexible because we can just .push() elements at the back to
@@ -142,9 +160,26 @@ mergeInto(LibraryManager.library, {
       if (node.usedBytes == newSize) return;
       if (newSize == 0) {
         node.contents = null; // Fully decommit when requesting a resize to zero.
+#if MEMFS_CHUNK_SIZE
+        node.chunks = null;
+#endif
         node.usedBytes = 0;
         return;
       }
+#if MEMFS_CHUNK_SIZE
+      if (node.chunks || newSize > {{{ MEMFS_CHUNK_SIZE }}}) {
+        MEMFS.expandFileStorage(node, newSize);
+        var numChunks = Math.ceil(newSize / {{{ MEMFS_CHUNK_SIZE }}});
+        if (newSize < node.usedBytes) {
+          // Drop the chunks past the new end, and clear the rest of the last one so that growing the file again reads zeros.
+          node.chunks.length = numChunks;
+          var last = node.chunks[numChunks - 1];
+          for (var i = newSize - (numChunks - 1) * {{{ MEMFS_CHUNK_SIZE }}}; i < last.length; i++) last[i] = 0;
+        }
+        node.usedBytes = newSize;
+        return;
+      }
+#endif
       if (!node.contents || node.contents.subarray) { // Resize a typed array if that is being used as the backing store.
         var oldContents = node.contents;
         node.contents = new Uint8Array(new ArrayBuffer(newSize)); // Allocate new storage.
@@ -161,6 +196,56 @@ mergeInto(LibraryManager.library, {
       node.usedBytes = newSize;
     },
 
+#if MEMFS_CHUNK_SIZE
+    // Moves the contents of a file into chunked storage. Done once, when the file first outgrows a chunk.
+    convertToChunks: function(node) {
+      var data = MEMFS.getFileDataAsTypedArray(node);
+      node.chunks = [];
+      for (var pos = 0; pos < node.usedBytes; pos += {{{ MEMFS_CHUNK_SIZE }}}) {
+        var chunk = new Uint8Array({{{ MEMFS_CHUNK_SIZE }}});
+        chunk.set(data.subarray(pos, pos + {{{ MEMFS_CHUNK_SIZE }}}));
+        node.chunks.push(chunk);
+      }
+      node.contents = null;
+    },
+
+    // Gathers length bytes at the given position in a chunked file into buffer[offset].
+    readChunks: function(node, buffer, offset, length, position) {
+      while (length > 0) {
+        var chunk = node.chunks[Math.floor(position / {{{ MEMFS_CHUNK_SIZE }}})];
+        var start = position % {{{ MEMFS_CHUNK_SIZE }}};
+        var size = Math.min(length, {{{ MEMFS_CHUNK_SIZE }}} - start);
+        if (buffer.subarray) {
+          buffer.set(chunk.subarray(start, start + size), offset);
+        } else {
+          for (var i = 0; i < size; i++) buffer[offset + i] = chunk[start + i];
+        }
+        offset += size;
+        position += size;
+        length -= size;
+      }
+    },
+
+    // Scatters buffer[offset] to buffer[offset+length] into a chunked file at the given position, growing it as needed.
+    writeChunks: function(node, buffer, offset, length, position) {
+      MEMFS.expandFileStorage(node, position + length);
+      node.usedBytes = Math.max(node.usedBytes, position + length);
+      while (length > 0) {
+        var chunk = node.chunks[Math.floor(position / {{{ MEMFS_CHUNK_SIZE }}})];
+        var start = position % {{{ MEMFS_CHUNK_SIZE }}};
+        var size = Math.min(length, {{{ MEMFS_CHUNK_SIZE }}} - start);
+        if (buffer.subarray) {
+          chunk.set(buffer.subarray(offset, offset + size), start);
+        } else {
+          for (var i = 0; i < size; i++) chunk[start + i] = buffer[offset + i];
+        }
+        offset += size;
+        position += size;
+        length -= size;
+      }
+    },
+#endif
+
     node_ops: {
       getattr: function(node) {
         var attr = {};
@@ -265,6 +350,12 @@ mergeInto(LibraryManager.library, {
         if (position >= stream.node.usedBytes) return 0;
         var size = Math.min(stream.node.usedBytes - position, length);
         assert(size >= 0);
+#if MEMFS_CHUNK_SIZE
+        if (stream.node.chunks) {
+          MEMFS.readChunks(stream.node, buffer, offset, size, position);
+          return size;
+        }
+#endif
         if (size > 8 && contents.subarray) { // non-trivial, and typed array
           buffer.set(contents.subarray(position, position + size), offset);
         } else {
@@ -284,6 +375,12 @@ mergeInto(LibraryManager.library, {
         var node = stream.node;
         node.timestamp = Date.now();
 
+#if MEMFS_CHUNK_SIZE
+        if (node.chunks) {
+          MEMFS.writeChunks(node, buffer, offset, length, position);
+          return length;
+        }
+#endif
         if (buffer.subarray && (!node.contents || node.contents.subarray)) { // This write is from a typed array to a typed array?
           if (canOwn) {
 #if ASSERTIONS
@@ -304,6 +401,12 @@ mergeInto(LibraryManager.library, {
 
         // Appending to an existing file and we need to reallocate, or source data did not come as a typed array.
         MEMFS.expandFileStorage(node, position+length);
+#if MEMFS_CHUNK_SIZE
+        if (node.chunks) { // The file just outgrew a single chunk.
+          MEMFS.writeChunks(node, buffer, offset, length, position);
+          return length;
+        }
+#endif
         if (node.contents.subarray && buffer.subarray) node.contents.set(buffer.subarray(offset, offset + length), position); // Use typed array write if available.
         else {
           for (var i = 0; i < length; i++) {
@@ -338,6 +441,16 @@ mergeInto(LibraryManager.library, {
         }
         var ptr;
         var allocated;
+#if MEMFS_CHUNK_SIZE
+        if (stream.node.chunks) { // Chunked files are never backed by the heap, so always map a copy.
+          ptr = _malloc(length);
+          if (!ptr) {
+            throw new FS.ErrnoError(ERRNO_CODES.ENOMEM);
+          }
+          MEMFS.stream_ops.read(stream, buffer, ptr, length, position);
+          return { ptr: ptr, allocated: true };
+        }
+#endif
         var contents = stream.node.contents;
         // Only make a new copy when MAP_PRIVATE is specified.
         if ( !(flags & {{{ cDefine('MAP_PRIVATE') }}}) &&
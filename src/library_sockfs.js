@@ -52,7 +52,7 @@ mergeInto(LibraryManager.library, {
         error: null, // Used in getsockopt for SOL_SOCKET/SO_ERROR test
         peers: {},
         pending: [],
-        recv_queue: [],
+        recv_queue: SOCKFS.createQueue(),
 #if SOCKET_WEBRTC
 #else
         sock_ops: SOCKFS.websocket_sock_ops
@@ -116,6 +116,36 @@ mergeInto(LibraryManager.library, {
         sock.sock_ops.close(sock);
       }
     },
+    // received messages wait in a ring buffer, so taking one off the front
+    // costs the same however far behind the application has fallen
+    createQueue: function() {
+      return { items: new Array(16), head: 0, length: 0 };
+    },
+    enqueue: function(queue, item) {
+      var items = queue.items;
+      if (queue.length === items.length) {
+        // full, so unroll it into one twice the size
+        var grown = new Array(items.length * 2);
+        for (var i = 0; i < queue.length; i++) {
+          grown[i] = items[(queue.head + i) & (items.length - 1)];
+        }
+        items = queue.items = grown;
+        queue.head = 0;
+      }
+      items[(queue.head + queue.length) & (items.length - 1)] = item;
+      queue.length++;
+    },
+    peekQueue: function(queue) {
+      return queue.length ? queue.items[queue.head] : null;
+    },
+    dequeue: function(queue) {
+      if (!queue.length) return null;
+      var item = queue.items[queue.head];
+      queue.items[queue.head] = undefined;
+      queue.head = (queue.head + 1) & (queue.items.length - 1);
+      queue.length--;
+      return item;
+    },
     nextname: function() {
       if (!SOCKFS.nextname.current) {
         SOCKFS.nextname.current = 0;
@@ -314,7 +344,7 @@ mergeInto(LibraryManager.library, {
             return;
           }
 
-          sock.recv_queue.push({ addr: peer.addr, port: peer.port, data: data });
+          SOCKFS.enqueue(sock.recv_queue, { addr: peer.addr, port: peer.port, data: data });
           Module['websocket'].emit('message', sock.stream.fd);
         };
 
@@ -393,8 +423,9 @@ mergeInto(LibraryManager.library, {
         switch (request) {
           case {{{ cDefine('FIONREAD') }}}:
             var bytes = 0;
-            if (sock.recv_queue.length) {
-              bytes = sock.recv_queue[0].data.length;
+            var queued = SOCKFS.peekQueue(sock.recv_queue);
+            if (queued) {
+              bytes = queued.data.length;
             }
             {{{ makeSetValue('arg', '0', 'bytes', 'i32') }}};
             return 0;
@@ -646,7 +677,7 @@ mergeInto(LibraryManager.library, {
           throw new FS.ErrnoError(ERRNO_CODES.ENOTCONN);
         }
 
-        var queued = sock.recv_queue.shift();
+        var queued = SOCKFS.peekQueue(sock.recv_queue);
         if (!queued) {
           if (sock.type === {{{ cDefine('SOCK_STREAM') }}}) {
             var dest = SOCKFS.websocket_sock_ops.getPeer(sock, sock.daddr, sock.dport);
@@ -684,14 +715,15 @@ mergeInto(LibraryManager.library, {
         Module.print('websocket read (' + bytesRead + ' bytes): ' + [Array.prototype.slice.call(res.buffer)]);
 #endif
 
-        // push back any unread data for TCP connections
+        // leave any unread data at the front of the queue for TCP connections
         if (sock.type === {{{ cDefine('SOCK_STREAM') }}} && bytesRead < queuedLength) {
           var bytesRemaining = queuedLength - bytesRead;
 #if SOCKET_DEBUG
           Module.print('websocket read: put back ' + bytesRemaining + ' bytes');
 #endif
           queued.data = new Uint8Array(queuedBuffer, queuedOffset + bytesRead, bytesRemaining);
-          sock.recv_queue.unshift(queued);
+        } else {
+          SOCKFS.dequeue(sock.recv_queue);
         }
 
         return res;
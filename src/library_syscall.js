@@ -197,6 +197,111 @@ var SyscallsLibrary = {
 #endif
       return info;
     },
+
+    // scatter-gather socket messages
+
+    // scratch space that outgoing messages are gathered into; sendmsg copies
+    // out what it sends, so this can be reused by every send
+    msgBuffer: null,
+    getMsgBuffer: function(size) {
+      var buffer = SYSCALLS.msgBuffer;
+      if (!buffer || buffer.length < size) {
+        buffer = SYSCALLS.msgBuffer = new Uint8Array(Math.max(size, buffer ? buffer.length * 2 : 4096));
+      }
+      return buffer;
+    },
+    getMsgLength: function(message) {
+      var iov = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iov, '*') }}};
+      var num = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iovlen, 'i32') }}};
+      var total = 0;
+      for (var i = 0; i < num; i++) {
+        total += {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_len, 'i32') }}};
+      }
+      return total;
+    },
+    // concatenates a message's scatter-gather arrays into buffer at offset, returning the new offset
+    gatherMsg: function(message, buffer, offset) {
+      var iov = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iov, '*') }}};
+      var num = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iovlen, 'i32') }}};
+      for (var i = 0; i < num; i++) {
+        var iovbase = {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_base, 'i8*') }}};
+        var iovlen = {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_len, 'i32') }}};
+        buffer.set(HEAPU8.subarray(iovbase, iovbase + iovlen), offset);
+        offset += iovlen;
+      }
+      return offset;
+    },
+    doSendmsg: function(sock, message) {
+      var iov = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iov, '*') }}};
+      var num = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iovlen, 'i32') }}};
+      // read the address and port to send to
+      var addr, port;
+      var name = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_name, '*') }}};
+      var namelen = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_namelen, 'i32') }}};
+      if (name) {
+        var info = __read_sockaddr(name, namelen);
+        if (info.errno) throw new FS.ErrnoError(info.errno);
+        port = info.port;
+        addr = DNS.lookup_addr(info.addr) || info.addr;
+      }
+      // a single array can be sent straight from the heap
+      if (num === 1) {
+        var iovbase = {{{ makeGetValue('iov', C_STRUCTS.iovec.iov_base, 'i8*') }}};
+        var iovlen = {{{ makeGetValue('iov', C_STRUCTS.iovec.iov_len, 'i32') }}};
+        return sock.sock_ops.sendmsg(sock, HEAPU8, iovbase, iovlen, addr, port);
+      }
+      var total = SYSCALLS.getMsgLength(message);
+      var buffer = SYSCALLS.getMsgBuffer(total);
+      SYSCALLS.gatherMsg(message, buffer, 0);
+      return sock.sock_ops.sendmsg(sock, buffer, 0, total, addr, port);
+    },
+    doRecvmsg: function(sock, message) {
+      var iov = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iov, 'i8*') }}};
+      var num = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iovlen, 'i32') }}};
+      // try to read the total amount of data we can take across all arrays
+      var msg = sock.sock_ops.recvmsg(sock, SYSCALLS.getMsgLength(message));
+      if (!msg) return 0; // socket is closed
+
+      // TODO honor flags:
+      // MSG_OOB
+      // Requests out-of-band data. The significance and semantics of out-of-band data are protocol-specific.
+      // MSG_PEEK
+      // Peeks at the incoming message.
+      // MSG_WAITALL
+      // Requests that the function block until the full amount of data requested can be returned. The function may return a smaller amount of data if a signal is caught, if the connection is terminated, if MSG_PEEK was specified, or if an error is pending for the socket.
+
+      // write the source address out
+      var name = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_name, '*') }}};
+      if (name) {
+        var res = __write_sockaddr(name, sock.family, DNS.lookup_name(msg.addr), msg.port);
+        assert(!res.errno);
+      }
+      // write the buffer out to the scatter-gather arrays
+      var bytesRead = 0;
+      var bytesRemaining = msg.buffer.byteLength;
+      for (var i = 0; bytesRemaining > 0 && i < num; i++) {
+        var iovbase = {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_base, 'i8*') }}};
+        var iovlen = {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_len, 'i32') }}};
+        if (!iovlen) {
+          continue;
+        }
+        var length = Math.min(iovlen, bytesRemaining);
+        HEAPU8.set(msg.buffer.subarray(bytesRead, bytesRead + length), iovbase);
+        bytesRead += length;
+        bytesRemaining -= length;
+      }
+
+      // TODO set msghdr.msg_flags
+      // MSG_EOR
+      // End of record was received (if supported by the protocol).
+      // MSG_OOB
+      // Out-of-band data was received.
+      // MSG_TRUNC
+      // Normal data was truncated.
+      // MSG_CTRUNC
+
+      return bytesRead;
+    },
 #endif // NO_FILESYSTEM == 0
     get64: function() {
       var low = SYSCALLS.get(), high = SYSCALLS.get();
@@ -534,88 +639,11 @@ var SyscallsLibrary = {
       }
       case 16: { // sendmsg
         var sock = SYSCALLS.getSocketFromFD(), message = SYSCALLS.get(), flags = SYSCALLS.get();
-        var iov = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iov, '*') }}};
-        var num = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iovlen, 'i32') }}};
-        // read the address and port to send to
-        var addr, port;
-        var name = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_name, '*') }}};
-        var namelen = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_namelen, 'i32') }}};
-        if (name) {
-          var info = __read_sockaddr(name, namelen);
-          if (info.errno) return -info.errno;
-          port = info.port;
-          addr = DNS.lookup_addr(info.addr) || info.addr;
-        }
-        // concatenate scatter-gather arrays into one message buffer
-        var total = 0;
-        for (var i = 0; i < num; i++) {
-          total += {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_len, 'i32') }}};
-        }
-        var view = new Uint8Array(total);
-        var offset = 0;
-        for (var i = 0; i < num; i++) {
-          var iovbase = {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_base, 'i8*') }}};
-          var iovlen = {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_len, 'i32') }}};
-          for (var j = 0; j < iovlen; j++) {  
-            view[offset++] = {{{ makeGetValue('iovbase', 'j', 'i8') }}};
-          }
-        }
-        // write the buffer
-        return sock.sock_ops.sendmsg(sock, view, 0, total, addr, port);
+        return SYSCALLS.doSendmsg(sock, message);
       }
       case 17: { // recvmsg
         var sock = SYSCALLS.getSocketFromFD(), message = SYSCALLS.get(), flags = SYSCALLS.get();
-        var iov = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iov, 'i8*') }}};
-        var num = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_iovlen, 'i32') }}};
-        // get the total amount of data we can read across all arrays
-        var total = 0;
-        for (var i = 0; i < num; i++) {
-          total += {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_len, 'i32') }}};
-        }
-        // try to read total data
-        var msg = sock.sock_ops.recvmsg(sock, total);
-        if (!msg) return 0; // socket is closed
-
-        // TODO honor flags:
-        // MSG_OOB
-        // Requests out-of-band data. The significance and semantics of out-of-band data are protocol-specific.
-        // MSG_PEEK
-        // Peeks at the incoming message.
-        // MSG_WAITALL
-        // Requests that the function block until the full amount of data requested can be returned. The function may return a smaller amount of data if a signal is caught, if the connection is terminated, if MSG_PEEK was specified, or if an error is pending for the socket.
-
-        // write the source address out
-        var name = {{{ makeGetValue('message', C_STRUCTS.msghdr.msg_name, '*') }}};
-        if (name) {
-          var res = __write_sockaddr(name, sock.family, DNS.lookup_name(msg.addr), msg.port);
-          assert(!res.errno);
-        }
-        // write the buffer out to the scatter-gather arrays
-        var bytesRead = 0;
-        var bytesRemaining = msg.buffer.byteLength;
-        for (var i = 0; bytesRemaining > 0 && i < num; i++) {
-          var iovbase = {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_base, 'i8*') }}};
-          var iovlen = {{{ makeGetValue('iov', '(' + C_STRUCTS.iovec.__size__ + ' * i) + ' + C_STRUCTS.iovec.iov_len, 'i32') }}};
-          if (!iovlen) {
-            continue;
-          }
-          var length = Math.min(iovlen, bytesRemaining);
-          var buf = msg.buffer.subarray(bytesRead, bytesRead + length);
-          HEAPU8.set(buf, iovbase + bytesRead);
-          bytesRead += length;
-          bytesRemaining -= length;
-        }
-
-        // TODO set msghdr.msg_flags
-        // MSG_EOR
-        // End of record was received (if supported by the protocol).
-        // MSG_OOB
-        // Out-of-band data was received.
-        // MSG_TRUNC
-        // Normal data was truncated.
-        // MSG_CTRUNC
-
-        return bytesRead;
+        return SYSCALLS.doRecvmsg(sock, message);
       }
       default: abort('unsupported socketcall syscall ' + call);
     }
@@ -1280,11 +1308,27 @@ var SyscallsLibrary = {
     var stream = SYSCALLS.getStreamFromFD(), iov = SYSCALLS.get(), iovcnt = SYSCALLS.get(), offset = SYSCALLS.get();
     return SYSCALLS.doWritev(stream, iov, iovcnt, offset);
   },
+  __syscall337__deps: ['$SOCKFS', '$DNS', '_write_sockaddr'],
   __syscall337: function(which, varargs) { // recvmmsg
-#if SYSCALL_DEBUG
-    Module.printErr('warning: ignoring SYS_recvmmsg');
-#endif
-    return 0;
+    var sock = SYSCALLS.getSocketFromFD(), msgvec = SYSCALLS.get(), vlen = SYSCALLS.get(), flags = SYSCALLS.get(), timeout = SYSCALLS.get();
+    // sockets never block, so this takes whatever is queued (and timeout is moot); like
+    // recvmsg it fails if nothing is, otherwise it returns how many messages it received
+    vlen = Math.min(vlen, 1024 /* UIO_MAXIOV */);
+    for (var i = 0; i < vlen; i++) {
+      var message = msgvec + i * {{{ C_STRUCTS.mmsghdr.__size__ }}};
+      try {
+        var bytesRead = SYSCALLS.doRecvmsg(sock, message + {{{ C_STRUCTS.mmsghdr.msg_hdr }}});
+      } catch (e) {
+        if (!i || !(e instanceof FS.ErrnoError)) throw e;
+        break;
+      }
+      {{{ makeSetValue('message', C_STRUCTS.mmsghdr.msg_len, 'bytesRead', 'i32') }}};
+      if (!bytesRead && sock.type === {{{ cDefine('SOCK_STREAM') }}}) {
+        i++;
+        break; // the connection was closed
+      }
+    }
+    return i;
   },
   __syscall340: function(which, varargs) { // prlimit64
     var pid = SYSCALLS.get(), resource = SYSCALLS.get(), new_limit = SYSCALLS.get(), old_limit = SYSCALLS.get();
@@ -1296,11 +1340,42 @@ var SyscallsLibrary = {
     }
     return 0;
   },
+  __syscall345__deps: ['$SOCKFS', '$DNS', '_read_sockaddr'],
   __syscall345: function(which, varargs) { // sendmmsg
-#if SYSCALL_DEBUG
-    Module.printErr('warning: ignoring SYS_sendmmsg');
-#endif
-    return 0;
+    var sock = SYSCALLS.getSocketFromFD(), msgvec = SYSCALLS.get(), vlen = SYSCALLS.get(), flags = SYSCALLS.get();
+    vlen = Math.min(vlen, 1024 /* UIO_MAXIOV */);
+    if (!vlen) return 0;
+    if (sock.type === {{{ cDefine('SOCK_STREAM') }}}) {
+      // a stream has no message boundaries to keep, so coalesce the whole
+      // batch into one buffer and send it as a single frame
+      var total = 0;
+      for (var i = 0; i < vlen; i++) {
+        total += SYSCALLS.getMsgLength(msgvec + i * {{{ C_STRUCTS.mmsghdr.__size__ }}} + {{{ C_STRUCTS.mmsghdr.msg_hdr }}});
+      }
+      var buffer = SYSCALLS.getMsgBuffer(total);
+      var offset = 0;
+      for (var i = 0; i < vlen; i++) {
+        var message = msgvec + i * {{{ C_STRUCTS.mmsghdr.__size__ }}};
+        var start = offset;
+        offset = SYSCALLS.gatherMsg(message + {{{ C_STRUCTS.mmsghdr.msg_hdr }}}, buffer, offset);
+        {{{ makeSetValue('message', C_STRUCTS.mmsghdr.msg_len, 'offset - start', 'i32') }}};
+      }
+      sock.sock_ops.sendmsg(sock, buffer, 0, total);
+      return vlen;
+    }
+    // datagrams go out one per message; like sendmsg this fails if the first
+    // one can't be sent, otherwise it returns how many messages were sent
+    for (var i = 0; i < vlen; i++) {
+      var message = msgvec + i * {{{ C_STRUCTS.mmsghdr.__size__ }}};
+      try {
+        var bytesSent = SYSCALLS.doSendmsg(sock, message + {{{ C_STRUCTS.mmsghdr.msg_hdr }}});
+      } catch (e) {
+        if (!i || !(e instanceof FS.ErrnoError)) throw e;
+        break;
+      }
+      {{{ makeSetValue('message', C_STRUCTS.mmsghdr.msg_len, 'bytesSent', 'i32') }}};
+    }
+    return i;
   },
 };
 
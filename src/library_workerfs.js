@@ -4,6 +4,10 @@ mergeInto(LibraryManager.library, {
     DIR_MODE: {{{ cDefine('S_IFDIR') }}} | 511 /* 0777 */,
     FILE_MODE: {{{ cDefine('S_IFREG') }}} | 511 /* 0777 */,
     reader: null,
+    // Reads are served from a window of the file that each stream keeps. It starts at the blocks a read needs, and doubles
+    // each time the stream reads on past its end, so small reads straight through a file take few, large slices of it.
+    BLOCK_SIZE: 4096,
+    MAX_WINDOW_SIZE: 4*1024*1024,
     mount: function (mount) {
       assert(ENVIRONMENT_IS_WORKER);
       if (!WORKERFS.reader) WORKERFS.reader = new FileReaderSync();
@@ -128,10 +132,38 @@ mergeInto(LibraryManager.library, {
     stream_ops: {
       read: function (stream, buffer, offset, length, position) {
         if (position >= stream.node.size) return 0;
-        var chunk = stream.node.contents.slice(position, position + length);
-        var ab = WORKERFS.reader.readAsArrayBuffer(chunk);
-        buffer.set(new Uint8Array(ab), offset);
-        return chunk.size;
+        length = Math.min(length, stream.node.size - position);
+        var written = 0;
+        while (written < length) {
+          var curr = position + written;
+          var span = stream.window;
+          if (!span || curr < span.start || curr >= span.start + span.data.length) {
+            var size = WORKERFS.BLOCK_SIZE;
+            if (span && curr === span.start + span.data.length) {
+              size = Math.min(span.size * 2, WORKERFS.MAX_WINDOW_SIZE);
+            }
+            if (length - written > WORKERFS.MAX_WINDOW_SIZE) {
+              // too large to keep around, read it directly
+              var chunk = stream.node.contents.slice(curr, position + length);
+              buffer.set(new Uint8Array(WORKERFS.reader.readAsArrayBuffer(chunk)), offset + written);
+              stream.window = { start: position + length, data: new Uint8Array(0), size: WORKERFS.MAX_WINDOW_SIZE };
+              return length;
+            }
+            var start = curr - curr % WORKERFS.BLOCK_SIZE;
+            var end = Math.max(start + size, position + length);
+            end = Math.min(end + (WORKERFS.BLOCK_SIZE - end % WORKERFS.BLOCK_SIZE) % WORKERFS.BLOCK_SIZE, stream.node.size);
+            span = stream.window = {
+              start: start,
+              data: new Uint8Array(WORKERFS.reader.readAsArrayBuffer(stream.node.contents.slice(start, end))),
+              size: Math.max(size, end - start),
+            };
+          }
+          var startInWindow = curr - span.start;
+          var endInWindow = Math.min(startInWindow + length - written, span.data.length);
+          buffer.set(span.data.subarray(startInWindow, endInWindow), offset + written);
+          written += endInWindow - startInWindow;
+        }
+        return written;
       },
       write: function (stream, buffer, offset, length, position) {
         throw new FS.ErrnoError(ERRNO_CODES.EIO);
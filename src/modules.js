@@ -125,6 +125,7 @@ var LibraryManager = {
           'library_sockfs.js',
           'library_workerfs.js',
           'library_lz4.js',
+          'library_aio.js',
         ]);
 
         if (NODERAWFS) {
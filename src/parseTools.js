@@ -1484,3 +1484,59 @@ function makeRetainedCompilerSettings() {
   return ret;
 }
 
+
+// Generates embind's static invoker factories for EMBIND_STATIC_INVOKERS: one
+// per combination of argument count (up to EMBIND_STATIC_INVOKERS_MAX_ARGS),
+// free function vs. method, and void vs. non-void return, keyed like 'mr2'.
+// craftInvokerFunction picks the factory matching a binding's shape instead
+// of compiling a new invoker with new Function, so every binding with the
+// same shape shares one piece of code.
+function makeEmbindStaticInvokers() {
+  var factories = [];
+  for (var argCount = 0; argCount <= EMBIND_STATIC_INVOKERS_MAX_ARGS; argCount++) {
+    [false, true].forEach(function(isMethod) {
+      [false, true].forEach(function(returns) {
+        var args = [], wired = [];
+        for (var i = 0; i < argCount; i++) {
+          args.push('arg' + i);
+          wired.push('arg' + i + 'Wired');
+        }
+        if (isMethod) wired.unshift('thisWired');
+
+        var code = 'function(humanName, argTypes, invoker, fn, needsDestructorStack) {\n';
+        if (returns) code += '  var retType = argTypes[0];\n';
+        if (isMethod) code += '  var classParam = argTypes[1], classParam_dtor = classParam.destructorFunction;\n';
+        for (var i = 0; i < argCount; i++) {
+          code += '  var argType' + i + ' = argTypes[' + (i + 2) + '], argType' + i + '_dtor = argType' + i + '.destructorFunction;\n';
+        }
+        code += '  return function(' + args.join(', ') + ') {\n' +
+                '    if (arguments.length !== ' + argCount + ') {\n' +
+                "      throwBindingError('function ' + humanName + ' called with ' + arguments.length + ' arguments, expected " + argCount + " args!');\n" +
+                '    }\n';
+        if (EMSCRIPTEN_TRACING) code += "    Module.emscripten_trace_enter_context('embind::' + humanName);\n";
+        code += '    var destructors = needsDestructorStack ? [] : null;\n';
+        if (isMethod) code += "    var thisWired = classParam['toWireType'](destructors, this);\n";
+        for (var i = 0; i < argCount; i++) {
+          code += '    var arg' + i + "Wired = argType" + i + "['toWireType'](destructors, arg" + i + ');\n';
+        }
+        code += '    ' + (returns ? 'var rv = ' : '') + 'invoker(' + ['fn'].concat(wired).join(', ') + ');\n';
+        if (wired.length) {
+          code += '    if (needsDestructorStack) {\n' +
+                  '      runDestructors(destructors);\n' +
+                  '    } else {\n';
+          if (isMethod) code += '      if (classParam_dtor) classParam_dtor(thisWired);\n';
+          for (var i = 0; i < argCount; i++) {
+            code += '      if (argType' + i + '_dtor) argType' + i + '_dtor(arg' + i + 'Wired);\n';
+          }
+          code += '    }\n';
+        }
+        if (returns) code += "    var ret = retType['fromWireType'](rv);\n";
+        if (EMSCRIPTEN_TRACING) code += '    Module.emscripten_trace_exit_context();\n';
+        if (returns) code += '    return ret;\n';
+        code += '  };\n}';
+        factories.push((isMethod ? 'm' : 'f') + (returns ? 'r' : 'v') + argCount + ': ' + code);
+      });
+    });
+  }
+  return '{\n' + factories.join(',\n') + '\n}';
+}
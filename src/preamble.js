@@ -430,7 +430,16 @@ function UTF8ArrayToString(u8Array, idx) {
   var endPtr = idx;
   // TextDecoder needs to know the byte length in advance, it doesn't stop on null terminator by itself.
   // Also, use the length info to avoid running tiny strings through TextDecoder, since .subarray() allocates garbage.
-  while (u8Array[endPtr]) ++endPtr;
+  // Past the first few bytes, the search is left to indexOf(), which the VM does a word or vector at a time.
+  while (u8Array[endPtr] && endPtr - idx < 16) ++endPtr;
+  if (u8Array[endPtr]) {
+    if (u8Array.indexOf) {
+      endPtr = u8Array.indexOf(0, endPtr);
+      if (endPtr < 0) endPtr = u8Array.length;
+    } else {
+      while (u8Array[endPtr]) ++endPtr;
+    }
+  }
 
   if (endPtr - idx > 16 && u8Array.subarray && UTF8Decoder) {
     return UTF8Decoder.decode(u8Array.subarray(idx, endPtr));
@@ -494,10 +503,22 @@ function UTF8ToString(ptr) {
 //                    maxBytesToWrite=0 does not write any bytes to the output, not even the null terminator.
 // Returns the number of bytes written, EXCLUDING the null terminator.
 
+#if TEXTDECODER
+var UTF8Encoder = typeof TextEncoder !== 'undefined' && TextEncoder.prototype.encodeInto ? new TextEncoder() : undefined;
+#endif
 function stringToUTF8Array(str, outU8Array, outIdx, maxBytesToWrite) {
   if (!(maxBytesToWrite > 0)) // Parameter maxBytesToWrite is not optional. Negative values, 0, null, undefined and false each don't write out any bytes.
     return 0;
 
+#if TEXTDECODER
+  // Like the loop below, encodeInto() only writes whole characters, and stops at the first one that does not fit. As with
+  // TextDecoder, tiny strings are not worth the .subarray().
+  if (str.length > 16 && UTF8Encoder && outU8Array instanceof Uint8Array) {
+    var written = UTF8Encoder.encodeInto(str, outU8Array.subarray(outIdx, outIdx + maxBytesToWrite - 1)).written;
+    outU8Array[outIdx + written] = 0;
+    return written;
+  }
+#endif
   var startIdx = outIdx;
   var endIdx = outIdx + maxBytesToWrite - 1; // -1 for string null terminator.
   for (var i = 0; i < str.length; ++i) {
@@ -597,7 +618,15 @@ function UTF16ToString(ptr) {
   // TextDecoder needs to know the byte length in advance, it doesn't stop on null terminator by itself.
   // Also, use the length info to avoid running tiny strings through TextDecoder, since .subarray() allocates garbage.
   var idx = endPtr >> 1;
-  while (HEAP16[idx]) ++idx;
+  while (HEAP16[idx] && idx - (ptr >> 1) < 16) ++idx;
+  if (HEAP16[idx]) {
+    if (HEAPU16.indexOf) {
+      idx = HEAPU16.indexOf(0, idx);
+      if (idx < 0) idx = HEAPU16.length;
+    } else {
+      while (HEAP16[idx]) ++idx;
+    }
+  }
   endPtr = idx << 1;
 
   if (endPtr - ptr > 32 && UTF16Decoder) {
@@ -747,7 +776,7 @@ function lengthBytesUTF32(str) {
 function allocateUTF8(str) {
   var size = lengthBytesUTF8(str) + 1;
   var ret = _malloc(size);
-  if (ret) stringToUTF8Array(str, HEAP8, ret, size);
+  if (ret) stringToUTF8Array(str, HEAPU8, ret, size);
   return ret;
 }
 
@@ -755,7 +784,7 @@ function allocateUTF8(str) {
 function allocateUTF8OnStack(str) {
   var size = lengthBytesUTF8(str) + 1;
   var ret = stackAlloc(size);
-  stringToUTF8Array(str, HEAP8, ret, size);
+  stringToUTF8Array(str, HEAPU8, ret, size);
   return ret;
 }
 
@@ -958,7 +987,9 @@ if (!Module['reallocBuffer']) Module['reallocBuffer'] = function(size) {
 };
 #endif
 
-function enlargeMemory() {
+// Grows memory so that it holds at least requestedSize bytes, or, if that is not given, up to the current
+// DYNAMICTOP (which sbrk has already bumped past TOTAL_MEMORY).
+function enlargeMemory(requestedSize) {
 #if USE_PTHREADS
   abort('Cannot enlarge memory arrays, since compiling with pthreads support enabled (-s USE_PTHREADS=1).');
 #else
@@ -970,9 +1001,12 @@ function enlargeMemory() {
 #endif
 #else
   // TOTAL_MEMORY is the current size of the actual array, and DYNAMICTOP is the new top.
+  if (!requestedSize) {
+    requestedSize = HEAP32[DYNAMICTOP_PTR>>2];
 #if ASSERTIONS
-  assert(HEAP32[DYNAMICTOP_PTR>>2] > TOTAL_MEMORY); // This function should only ever be called after the ceiling of the dynamic heap has already been bumped to exceed the current total size of the asm.js heap.
+    assert(requestedSize > TOTAL_MEMORY); // This function should only ever be called after the ceiling of the dynamic heap has already been bumped to exceed the current total size of the asm.js heap.
 #endif
+  }
 
 #if EMSCRIPTEN_TRACING
   // Report old layout one last time
@@ -982,9 +1016,9 @@ function enlargeMemory() {
   var PAGE_MULTIPLE = Module["usingWasm"] ? WASM_PAGE_SIZE : ASMJS_PAGE_SIZE; // In wasm, heap size must be a multiple of 64KB. In asm.js, they need to be multiples of 16MB.
   var LIMIT = 2147483648 - PAGE_MULTIPLE; // We can do one page short of 2GB as theoretical maximum.
 
-  if (HEAP32[DYNAMICTOP_PTR>>2] > LIMIT) {
+  if (requestedSize > LIMIT) {
 #if ASSERTIONS
-    Module.printErr('Cannot enlarge memory, asked to go up to ' + HEAP32[DYNAMICTOP_PTR>>2] + ' bytes, but the limit is ' + LIMIT + ' bytes!');
+    Module.printErr('Cannot enlarge memory, asked to go up to ' + requestedSize + ' bytes, but the limit is ' + LIMIT + ' bytes!');
 #endif
     return false;
   }
@@ -992,12 +1026,17 @@ function enlargeMemory() {
   var OLD_TOTAL_MEMORY = TOTAL_MEMORY;
   TOTAL_MEMORY = Math.max(TOTAL_MEMORY, MIN_TOTAL_MEMORY); // So the loop below will not be infinite, and minimum asm.js memory size is 16MB.
 
-  while (TOTAL_MEMORY < HEAP32[DYNAMICTOP_PTR>>2]) { // Keep incrementing the heap size as long as it's less than what is requested.
+  while (TOTAL_MEMORY < requestedSize) { // Keep incrementing the heap size as long as it's less than what is requested.
+    var step;
     if (TOTAL_MEMORY <= 536870912) {
-      TOTAL_MEMORY = alignUp(2 * TOTAL_MEMORY, PAGE_MULTIPLE); // Simple heuristic: double until 1GB...
+      step = Math.floor(TOTAL_MEMORY * {{{ MEMORY_GROWTH_GEOMETRIC_STEP }}}); // Grow geometrically (by default, double) until 1GB...
     } else {
-      TOTAL_MEMORY = Math.min(alignUp((3 * TOTAL_MEMORY + 2147483648) / 4, PAGE_MULTIPLE), LIMIT); // ..., but after that, add smaller increments towards 2GB, which we cannot reach
+      step = (2147483648 - TOTAL_MEMORY) / 4; // ..., but after that, add smaller increments towards 2GB, which we cannot reach
     }
+#if MEMORY_GROWTH_GEOMETRIC_CAP
+    step = Math.min(step, {{{ MEMORY_GROWTH_GEOMETRIC_CAP }}});
+#endif
+    TOTAL_MEMORY = Math.min(alignUp(TOTAL_MEMORY + Math.max(step, PAGE_MULTIPLE), PAGE_MULTIPLE), LIMIT);
   }
 
 #if ASSERTIONS
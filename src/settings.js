@@ -81,6 +81,15 @@ var ALLOW_MEMORY_GROWTH = 0; // If false, we abort with an error if we try to al
                              // ALLOW_MEMORY_GROWTH enables fully standard behavior, of both malloc
                              // returning 0 when it fails, and also of being able to allocate more
                              // memory from the system as necessary.
+var MEMORY_GROWTH_GEOMETRIC_STEP = 1.0; // With ALLOW_MEMORY_GROWTH, how much memory grows by each time it has
+                                        // to, as a fraction of its current size (the default of 1.0 doubles it).
+                                        // Past 1GB, growth instead takes smaller steps towards the 2GB limit.
+                                        // Each growth copies the whole heap, so larger steps mean fewer copies
+                                        // at the cost of more unused memory.
+var MEMORY_GROWTH_GEOMETRIC_CAP = 0; // If nonzero, the most bytes a single growth step may add, so that large
+                                     // heaps do not double at once. Memory still grows by as much as the
+                                     // allocation being made requires. Programs that know ahead of time how
+                                     // much they will need can call emscripten_heap_reserve() to grow once.
 
 var GLOBAL_BASE = -1; // where global data begins; the start of static memory. -1 means use the
                       // default, any other value will be used as an override
@@ -300,6 +309,11 @@ var LZ4 = 0; // Enable this to support lz4-compressed file packages. They are st
              //     for special preloading operations like pre-decoding of images using browser codecs,
              //     preloadPlugin stuff, etc.
              //   * LZ4 files are read-only.
+var LZ4_CACHE_SIZE = 4096; // How many bytes of decompressed LZ4 chunks to keep cached, per package. Reads only
+                          // decompress the chunks they touch, so this bounds the memory used by a package beyond its
+                          // compressed data. Reads of whole chunks decompress straight into the output, and streams
+                          // that read straight through a file only use one cache slot, so neither evicts the chunks
+                          // that random reads keep coming back to. (The chunks are 2K, and at least two are cached.)
 
 var DISABLE_EXCEPTION_CATCHING = 0; // Disables generating code to actually catch exceptions. If the code you
                                     // are compiling does not actually rely on catching exceptions (but the
@@ -365,6 +379,10 @@ var MEMFS_APPEND_TO_TYPED_ARRAYS = 0; // If set to nonzero, MEMFS will always ut
                                       // for appending data to files. The default behavior is to use typed arrays for files
                                       // when the file size doesn't change after initial creation, and for files that do
                                       // change size, use normal JS arrays instead.
+var MEMFS_CHUNK_SIZE = 0; // If nonzero, MEMFS files that grow beyond this many bytes are stored as a list of
+                         // typed arrays of this size, so that growing a file never copies the data already written
+                         // to it. Useful for large files written incrementally. Takes precedence over
+                         // MEMFS_APPEND_TO_TYPED_ARRAYS for such files.
 var NO_FILESYSTEM = 0; // If set, does not build in any filesystem support. Useful if you are just doing pure
                        // computation, but not reading files or using any streams (including fprintf, and other
                        // stdio.h things) or anything related. The one exception is there is partial support for printf,
@@ -642,6 +660,14 @@ var NO_DYNAMIC_EXECUTION = 0; // When set to 1, we do not emit eval() and new Fu
                               // When set to -s NO_DYNAMIC_EXECUTION=2 flag is set, attempts to call to eval() are demoted
                               // to warnings instead of throwing an exception.
 
+var EMBIND_STATIC_INVOKERS = 0; // If set to 1, embind's JS invokers for bound functions and methods come from a table
+                                // generated at build time, with one specialized invoker per shape (argument count,
+                                // method or free function, void or non-void return) shared by every binding of that shape,
+                                // instead of being compiled with new Function() for each binding at startup. This speeds
+                                // up startup for modules with many bindings and, combined with NO_DYNAMIC_EXECUTION, avoids
+                                // new Function() for all bindings with up to EMBIND_STATIC_INVOKERS_MAX_ARGS arguments.
+var EMBIND_STATIC_INVOKERS_MAX_ARGS = 8; // The largest argument count that EMBIND_STATIC_INVOKERS generates invokers for.
+
 var EMTERPRETIFY = 0; // Runs tools/emterpretify on the compiler output
 var EMTERPRETIFY_FILE = ''; // If defined, a file to write bytecode to, otherwise the default is to embed it in text JS arrays (which is less efficient).
                             // When emitting HTML, we automatically generate code to load this file and set it to Module.emterpreterFile. If you
@@ -779,6 +805,21 @@ var IN_TEST_HARNESS = 0; // If true, the current build is performed for the Emsc
 
 var USE_PTHREADS = 0; // If true, enables support for pthreads.
 
+var MALLOC_THREAD_CACHE = 0; // If true (and USE_PTHREADS is enabled), malloc() and free() keep a small per-thread cache of
+                              // free blocks for each small size class, so that most small allocations do not contend on the
+                              // single dlmalloc lock. Ignored with SPLIT_MEMORY and --tracing.
+
+var MALLOC_LARGE_OBJECT_REGION = 0; // If true, dlmalloc keeps large chunks (256K and up by default, see M_MMAP_THRESHOLD
+                                    // in mallopt()) apart from the rest of the heap, and reuses them for later large
+                                    // allocations, so that large transient buffers do not fragment the heap of small
+                                    // objects or make it grow again. Ignored with SPLIT_MEMORY.
+
+var MALLOC_HEAP_PROFILER = 0; // If true, links in a sampling heap profiler: about one allocation per sample interval of
+                              // bytes allocated has its call stack recorded, and emscripten_heap_profiler_dump() writes
+                              // the live samples by call stack as a pprof heap profile. See emscripten/heap_profiler.h.
+                              // Function names in the profile need --profiling-funcs or -g. Ignored with USE_PTHREADS
+                              // and SPLIT_MEMORY.
+
 var PTHREAD_POOL_SIZE = 0; // Specifies the number of web workers that are preallocated before runtime is initialized. If 0, workers are created on demand.
 
 var DEFAULT_PTHREAD_STACK_SIZE = 2*1024*1024; // If not explicitly specified, this is the stack size to use for newly created pthreads.
@@ -853,7 +894,8 @@ var CYBERDWARF = 0; // see http://kripken.github.io/emscripten-site/docs/debuggi
 
 var BUNDLED_CD_DEBUG_FILE = ""; // Path to the CyberDWARF debug file passed to the compiler
 
-var TEXTDECODER = 1; // Is enabled, use the JavaScript TextDecoder API for string marshalling.
+var TEXTDECODER = 1; // Is enabled, use the JavaScript TextDecoder API for string marshalling, and TextEncoder.encodeInto()
+                     // where the browser has it, to encode strings straight into the heap.
                      // Enabled by default, set this to 0 to disable.
 
 var OFFSCREENCANVAS_SUPPORT = 0; // If set to 1, enables support for transferring canvases to pthreads and creating WebGL contexts in them,
@@ -65,6 +65,9 @@ namespace emscripten {
                 size_t charSize,
                 const char* name);
 
+            void _embind_register_string_arena(
+                StringArena* arena);
+
             void _embind_register_emval(
                 TYPEID emvalType,
                 const char* name);
@@ -1480,6 +1483,68 @@ namespace emscripten {
                 return true;
             }
         };
+
+        // Vectors of numbers that map onto a typed array also get bulk
+        // operations, which copy whole ranges with a single
+        // TypedArray.prototype.set() or slice() against the heap
+        // instead of crossing into JavaScript once per element.
+        template<typename VectorType,
+                 bool = typeSupportsMemoryView<typename VectorType::value_type>() &&
+                        !std::is_same<typename VectorType::value_type, bool>::value>
+        struct VectorBulkAccess {
+            static void bind(const class_<VectorType>&) {
+            }
+        };
+
+        template<typename VectorType>
+        struct VectorBulkAccess<VectorType, true> {
+            typedef typename VectorType::size_type size_type;
+
+            // Returns a typed array that aliases the vector's storage.
+            // It is invalidated when the vector reallocates or the
+            // heap grows.
+            static val view(const VectorType& v) {
+                return val(typed_memory_view(v.size(), v.data()));
+            }
+
+            static val toTypedArray(const VectorType& v) {
+                return view(v).template call<val>("slice");
+            }
+
+            static val getRange(const VectorType& v, size_type begin, size_type end) {
+                if (end > v.size()) {
+                    end = v.size();
+                }
+                if (begin > end) {
+                    begin = end;
+                }
+                return val(typed_memory_view(end - begin, v.data() + begin)).template call<val>("slice");
+            }
+
+            static bool setRange(VectorType& v, size_type index, val array) {
+                size_type length = array["length"].template as<size_type>();
+                if (index > v.size() || length > v.size() - index) {
+                    return false;
+                }
+                val(typed_memory_view(length, v.data() + index)).template call<void>("set", array);
+                return true;
+            }
+
+            static void assignFromTypedArray(VectorType& v, val array) {
+                v.resize(array["length"].template as<size_type>());
+                view(v).template call<void>("set", array);
+            }
+
+            static void bind(const class_<VectorType>& c) {
+                c
+                    .function("toTypedArray", &toTypedArray)
+                    .function("typedArrayView", &view)
+                    .function("getRange", &getRange)
+                    .function("setRange", &setRange)
+                    .function("assignFromTypedArray", &assignFromTypedArray)
+                    ;
+            }
+        };
     }
 
     template<typename T>
@@ -1488,14 +1553,17 @@ namespace emscripten {
 
         void (VecType::*push_back)(const T&) = &VecType::push_back;
         void (VecType::*resize)(const size_t, const T&) = &VecType::resize;
-        return class_<std::vector<T>>(name)
+        class_<std::vector<T>> c = class_<std::vector<T>>(name)
             .template constructor<>()
             .function("push_back", push_back)
             .function("resize", resize)
+            .function("reserve", &VecType::reserve)
             .function("size", &VecType::size)
             .function("get", &internal::VectorAccess<VecType>::get)
             .function("set", &internal::VectorAccess<VecType>::set)
             ;
+        internal::VectorBulkAccess<VecType>::bind(c);
+        return c;
     }
 
     ////////////////////////////////////////////////////////////////////////////////
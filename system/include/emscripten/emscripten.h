@@ -223,6 +223,8 @@ int emscripten_get_worker_queue_size(worker_handle worker);
 
 int emscripten_get_compiler_setting(const char *name);
 
+int emscripten_heap_reserve(size_t bytes);
+
 void emscripten_debugger(void);
 
 char *emscripten_get_preloaded_image_data(const char *path, int *w, int *h);
@@ -43,6 +43,17 @@ extern "C" {
 // to test or wair for its completion.
 #define EMSCRIPTEN_FETCH_WAITABLE 128
 
+// If specified, a proxied (waitable) fetch is started before any queued fetches of normal or low priority.
+// EMSCRIPTEN_FETCH_PRIORITY_HIGH and EMSCRIPTEN_FETCH_PRIORITY_LOW are mutually exclusive.
+#define EMSCRIPTEN_FETCH_PRIORITY_HIGH 256
+
+// If specified, a proxied (waitable) fetch is started only after all queued fetches of normal and high priority.
+// EMSCRIPTEN_FETCH_PRIORITY_HIGH and EMSCRIPTEN_FETCH_PRIORITY_LOW are mutually exclusive.
+#define EMSCRIPTEN_FETCH_PRIORITY_LOW 512
+
+// The number of priority classes that proxied fetches are queued in.
+#define EMSCRIPTEN_FETCH_NUM_PRIORITIES 3
+
 struct emscripten_fetch_t;
 
 // Specifies the parameters for a newly initiated fetch operation.
@@ -99,6 +110,27 @@ typedef struct emscripten_fetch_attr_t
 
 	// Specifies the length of the buffer pointed by 'requestData'. Leave as 0 if no request body needs to be sent.
 	size_t requestDataSize;
+
+	// If non-zero, the response body is written directly to this caller-provided memory instead of being allocated
+	// from the heap, and EMSCRIPTEN_FETCH_LOAD_TO_MEMORY has no effect. The memory is treated as a ring of
+	// 'numDestinationBuffers' buffers of 'destinationBufferSize' bytes each: when a buffer fills up, or when the
+	// transfer finishes, the onbufferfilled() handler is called with fetch->data pointing to the buffer, fetch->numBytes
+	// holding the number of bytes written to it and fetch->dataOffset holding its offset in the stream. The fetch then
+	// continues writing to the next buffer in the ring, so the handler needs to consume the data before returning.
+	// Combine with EMSCRIPTEN_FETCH_STREAM_DATA to fill the buffers as data arrives from the network.
+	// The memory is owned by the caller, and must stay valid until the fetch finishes or is closed.
+	// Note: onbufferfilled() is not called for fetches that are proxied to the fetch worker (EMSCRIPTEN_FETCH_WAITABLE),
+	// so for those, pass a single buffer large enough to hold the whole response.
+	char *destinationBuffer;
+
+	// Specifies the size in bytes of each buffer in the ring pointed to by 'destinationBuffer'.
+	size_t destinationBufferSize;
+
+	// Specifies the number of buffers in the ring pointed to by 'destinationBuffer'. 0 is treated as 1.
+	uint32_t numDestinationBuffers;
+
+	// Called each time a destination buffer has been filled. See 'destinationBuffer'.
+	void (*onbufferfilled)(struct emscripten_fetch_t *fetch);
 } emscripten_fetch_attr_t;
 
 typedef struct emscripten_fetch_t
@@ -120,6 +152,9 @@ typedef struct emscripten_fetch_t
 	//     chunk of bytes related to the transfer. Otherwise this will be null.
 	// The data buffer provided here has identical lifetime with the emscripten_fetch_t object itself, and is freed by
 	// calling emscripten_fetch_close() on the emscripten_fetch_t pointer.
+	// In onbufferfilled() handler:
+	//   - This points to the caller-provided destination buffer that was just filled. See
+	//     emscripten_fetch_attr_t::destinationBuffer.
 	const char *data;
 
 	// Specifies the length of the above data block in bytes. When the download finishes, this field will be valid even if
@@ -168,6 +203,10 @@ emscripten_fetch_t *emscripten_fetch(emscripten_fetch_attr_t *fetch_attr, const
 // this function returns.
 EMSCRIPTEN_RESULT emscripten_fetch_wait(emscripten_fetch_t *fetch, double timeoutMSecs);
 
+// Limits the number of proxied fetches that the fetch worker keeps running at the same time. Further proxied fetches
+// stay queued in order of priority until earlier ones finish. Pass 0 to remove the limit (the default).
+void emscripten_fetch_set_max_in_flight(unsigned int maxInFlight);
+
 // Closes a finished or an executing fetch operation and frees up all memory. If the fetch operation was still executing, the
 // onerror() handler will be called in the calling thread before this function returns.
 EMSCRIPTEN_RESULT emscripten_fetch_close(emscripten_fetch_t *fetch);
@@ -0,0 +1,28 @@
+#ifndef __emscripten_heap_profiler_h__
+#define __emscripten_heap_profiler_h__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The sampling heap profiler is linked in with -s MALLOC_HEAP_PROFILER=1.
+
+// Samples on average one allocation per this many bytes allocated. 0 stops sampling.
+void emscripten_heap_profiler_set_sample_interval(size_t bytes);
+
+// Writes the live sampled allocations, aggregated by call stack, to the given file in the legacy pprof heap profile
+// format, with symbols embedded. Returns 0 on success.
+int emscripten_heap_profiler_dump(const char *path);
+
+// Called by dlmalloc.
+void emscripten_heap_profiler_record_allocation(const void *address, size_t size);
+void emscripten_heap_profiler_record_free(const void *address);
+void emscripten_heap_profiler_record_reallocation(const void *old_address, const void *address, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __emscripten_heap_profiler_h__
@@ -56,6 +56,7 @@ namespace emscripten {
             EM_VAL _emval_get_global(const char* name);
             EM_VAL _emval_get_module_property(const char* name);
             EM_VAL _emval_get_property(EM_VAL object, EM_VAL key);
+            EM_VAL _emval_take_property(EM_VAL object, EM_VAL key);
             void _emval_set_property(EM_VAL object, EM_VAL key, EM_VAL value);
             EM_GENERIC_WIRE_TYPE _emval_as(EM_VAL value, TYPEID returnType, EM_DESTRUCTORS* destructors);
 
@@ -85,6 +86,12 @@ namespace emscripten {
                 const char* methodName,
                 EM_VAR_ARGS argv);
             EM_VAL _emval_typeof(EM_VAL value);
+            void _emval_run_batch(
+                const unsigned* commands,
+                unsigned commandCount,
+                const double* numbers,
+                EM_VAL* values,
+                double* numberResults);
         }
 
         template<const char* address>
@@ -148,6 +155,8 @@ namespace emscripten {
 
         template<typename T>
         T fromGenericWireType(double g) {
+            static_assert(!IsBorrowedWireType<typename std::remove_cv<T>::type>::value,
+                          "this type refers to memory that is released when the call returns; use std::string instead");
             typedef typename BindingType<T>::WireType WireType;
             WireType wt = GenericWireTypeConverter<WireType>::from(g);
             return BindingType<T>::fromWireType(wt);
@@ -338,23 +347,25 @@ namespace emscripten {
         val(const val& v)
             : handle(v.handle)
         {
-            internal::_emval_incref(handle);
+            incref(handle);
         }
 
         ~val() {
-            internal::_emval_decref(handle);
+            decref(handle);
         }
 
         val& operator=(val&& v) {
-            internal::_emval_decref(handle);
-            handle = v.handle;
-            v.handle = 0;
+            if (this != &v) {
+                decref(handle);
+                handle = v.handle;
+                v.handle = 0;
+            }
             return *this;
         }
 
         val& operator=(const val& v) {
-            internal::_emval_incref(v.handle);
-            internal::_emval_decref(handle);
+            incref(v.handle);
+            decref(handle);
             handle = v.handle;
             return *this;
         }
@@ -393,10 +404,20 @@ namespace emscripten {
         }
 
         template<typename T>
-        val operator[](const T& key) const {
+        val operator[](const T& key) const & {
             return val(internal::_emval_get_property(handle, val(key).handle));
         }
 
+        // On a temporary, such as in v["a"]["b"], hands the temporary's
+        // reference over to JavaScript, which releases it as part of the
+        // same call.
+        template<typename T>
+        val operator[](const T& key) && {
+            internal::EM_VAL object = handle;
+            handle = 0;
+            return val(internal::_emval_take_property(object, val(key).handle));
+        }
+
         template<typename K>
         void set(const K& key, const val& v) {
             internal::_emval_set_property(handle, val(key).handle, v.handle);
@@ -453,6 +474,25 @@ namespace emscripten {
             : handle(handle)
         {}
 
+        // The reserved undefined, null, true and false handles are not
+        // reference counted, and moved-from vals hold 0, so neither needs a
+        // call into JavaScript.
+        static bool isCounted(internal::EM_VAL handle) {
+            return reinterpret_cast<uintptr_t>(handle) > internal::_EMVAL_FALSE;
+        }
+
+        static void incref(internal::EM_VAL handle) {
+            if (isCounted(handle)) {
+                internal::_emval_incref(handle);
+            }
+        }
+
+        static void decref(internal::EM_VAL handle) {
+            if (isCounted(handle)) {
+                internal::_emval_decref(handle);
+            }
+        }
+
         template<typename WrapperType>
         friend val internal::wrapped_extend(const std::string& , const val& );
 
@@ -477,6 +517,156 @@ namespace emscripten {
         internal::EM_VAL handle;
 
         friend struct internal::BindingType<val>;
+        friend class val_batch;
+    };
+
+    // Records a sequence of property gets, sets and method calls and runs
+    // it in JavaScript with a single transition, instead of one import
+    // call (and one handle) per val operation. Intermediate values live in
+    // slots that exist only while the batch runs; only the slots passed to
+    // keep() come back as vals, and read_number() slots come back as plain
+    // doubles, both filled in bulk by run().
+    //
+    //     val_batch batch;
+    //     auto el = batch.call(batch.input(document), "getElementById", {batch.string("status")});
+    //     batch.set(el, "textContent", batch.string("ok"));
+    //     size_t width = batch.read_number(batch.get(el, "clientWidth"));
+    //     batch.run();
+    //     double w = batch.number_result(width);
+    //
+    // Vals passed to input() and the strings passed by pointer must stay
+    // alive until run() returns.
+    class val_batch {
+    public:
+        typedef unsigned slot;
+
+        val_batch()
+            : slotCount(0)
+        {}
+
+        ~val_batch() {
+            releaseValues();
+        }
+
+        val_batch(const val_batch&) = delete;
+        void operator=(const val_batch&) = delete;
+
+        slot input(const val& v) {
+            return produce({INPUT, address(v.handle)});
+        }
+
+        slot number(double value) {
+            numbers.push_back(value);
+            return produce({NUMBER, unsigned(numbers.size() - 1)});
+        }
+
+        slot string(const char* value) {
+            return produce({STRING, address(value)});
+        }
+
+        slot get(slot object, const char* key) {
+            return produce({GET, object, address(key)});
+        }
+
+        slot get(slot object, unsigned index) {
+            return produce({GET_INDEX, object, index});
+        }
+
+        void set(slot object, const char* key, slot value) {
+            commands.insert(commands.end(), {SET, object, address(key), value});
+        }
+
+        void set(slot object, unsigned index, slot value) {
+            commands.insert(commands.end(), {SET_INDEX, object, index, value});
+        }
+
+        slot call(slot object, const char* method, std::initializer_list<slot> args = {}) {
+            commands.insert(commands.end(), {CALL, object, address(method), unsigned(args.size())});
+            commands.insert(commands.end(), args);
+            return slotCount++;
+        }
+
+        // Returns an index for take() after run().
+        size_t keep(slot s) {
+            commands.insert(commands.end(), {KEEP, s, unsigned(values.size())});
+            values.push_back(internal::EM_VAL(internal::_EMVAL_UNDEFINED));
+            return values.size() - 1;
+        }
+
+        // Returns an index for number_result() after run().
+        size_t read_number(slot s) {
+            commands.insert(commands.end(), {READ_NUMBER, s, unsigned(numberResults.size())});
+            numberResults.push_back(0);
+            return numberResults.size() - 1;
+        }
+
+        void run() {
+            releaseValues();
+            internal::_emval_run_batch(
+                commands.data(),
+                commands.size(),
+                numbers.data(),
+                values.data(),
+                numberResults.data());
+        }
+
+        val take(size_t index) {
+            val v(values[index]);
+            values[index] = internal::EM_VAL(internal::_EMVAL_UNDEFINED);
+            return v;
+        }
+
+        double number_result(size_t index) const {
+            return numberResults[index];
+        }
+
+        // Forgets all recorded commands and results, keeping the buffers
+        // so that a batch can be rebuilt every frame without allocating.
+        void clear() {
+            releaseValues();
+            commands.clear();
+            numbers.clear();
+            values.clear();
+            numberResults.clear();
+            slotCount = 0;
+        }
+
+    private:
+        // Keep in sync with _emval_run_batch in emval.js.
+        enum Command : unsigned {
+            INPUT,       // handle
+            NUMBER,      // index into numbers
+            STRING,      // const char*
+            GET,         // object, const char* key
+            GET_INDEX,   // object, index
+            SET,         // object, const char* key, value
+            SET_INDEX,   // object, index, value
+            CALL,        // object, const char* method, argCount, args...
+            KEEP,        // slot, index into values
+            READ_NUMBER, // slot, index into numberResults
+        };
+
+        static unsigned address(const void* p) {
+            return unsigned(reinterpret_cast<uintptr_t>(p));
+        }
+
+        slot produce(std::initializer_list<unsigned> command) {
+            commands.insert(commands.end(), command);
+            return slotCount++;
+        }
+
+        void releaseValues() {
+            for (auto& v : values) {
+                val::decref(v);
+                v = internal::EM_VAL(internal::_EMVAL_UNDEFINED);
+            }
+        }
+
+        std::vector<unsigned> commands;
+        std::vector<double> numbers;
+        std::vector<internal::EM_VAL> values;
+        std::vector<double> numberResults;
+        unsigned slotCount;
     };
 
     namespace internal {
@@ -484,7 +674,7 @@ namespace emscripten {
         struct BindingType<val> {
             typedef internal::EM_VAL WireType;
             static WireType toWireType(const val& v) {
-                _emval_incref(v.handle);
+                val::incref(v.handle);
                 return v.handle;
             }
             static val fromWireType(WireType v) {
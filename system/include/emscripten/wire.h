@@ -15,6 +15,11 @@
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#ifdef __EMSCRIPTEN_PTHREADS__
+#include <emscripten/threading.h>
+#endif
 
 #define EMSCRIPTEN_ALWAYS_INLINE __attribute__((always_inline))
 
@@ -277,34 +282,91 @@ namespace emscripten {
             }
         };
 
-        template<>
-        struct BindingType<std::string> {
+        // Short strings crossing between C++ and JavaScript on the main
+        // runtime thread are carved out of this arena (defined in bind.cpp)
+        // instead of being malloc()ed. Allocation bumps top, and the arena
+        // rewinds once every string in it has been released by the side
+        // that reads it. embind.js mirrors this in allocateWireString and
+        // releaseWireString, so the layout must stay in sync.
+        struct StringArena {
+            char* base;
+            size_t capacity;
+            size_t top;
+            size_t live;
+        };
+
+        extern StringArena stringArena;
+
+        inline void* allocateWireString(size_t size) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+            if (!emscripten_is_main_runtime_thread()) {
+                return malloc(size);
+            }
+#endif
+            size = (size + 3) & ~3;
+            if (size <= stringArena.capacity - stringArena.top) {
+                void* p = stringArena.base + stringArena.top;
+                stringArena.top += size;
+                ++stringArena.live;
+                return p;
+            }
+            return malloc(size);
+        }
+
+        template<typename CharType>
+        struct StringWireType {
             typedef struct {
                 size_t length;
-                char data[1]; // trailing data
+                CharType data[1]; // trailing data
             }* WireType;
-            static WireType toWireType(const std::string& v) {
-                WireType wt = (WireType)malloc(sizeof(size_t) + v.length());
-                wt->length = v.length();
-                memcpy(wt->data, v.data(), v.length());
+
+            static WireType toWireType(const CharType* data, size_t length) {
+                WireType wt = (WireType)allocateWireString(sizeof(size_t) + length * sizeof(CharType));
+                wt->length = length;
+                memcpy(wt->data, data, length * sizeof(CharType));
                 return wt;
             }
+        };
+
+        template<>
+        struct BindingType<std::string> {
+            typedef StringWireType<char>::WireType WireType;
+            static WireType toWireType(const std::string& v) {
+                return StringWireType<char>::toWireType(v.data(), v.length());
+            }
             static std::string fromWireType(WireType v) {
                 return std::string(v->data, v->length);
             }
         };
 
+        // Shares the std::string representation on the JavaScript side.
+        // fromWireType does not copy: the view refers to the wire buffer,
+        // which JavaScript releases only after the call has returned.
+        template<>
+        struct BindingType<std::string_view> {
+            typedef StringWireType<char>::WireType WireType;
+            static WireType toWireType(std::string_view v) {
+                return StringWireType<char>::toWireType(v.data(), v.length());
+            }
+            static std::string_view fromWireType(WireType v) {
+                return std::string_view(v->data, v->length);
+            }
+        };
+
+        // Types whose fromWireType refers into the wire buffer, and so can be
+        // received as parameters of bound functions but not as the result of
+        // a call into JavaScript, whose buffer is released before it returns.
+        template<typename T>
+        struct IsBorrowedWireType : std::false_type {};
+
+        template<>
+        struct IsBorrowedWireType<std::string_view> : std::true_type {};
+
         template<>
         struct BindingType<std::wstring> {
-            typedef struct {
-                size_t length;
-                wchar_t data[1]; // trailing data
-            }* WireType;
+            typedef StringWireType<wchar_t>::WireType WireType;
             static WireType toWireType(const std::wstring& v) {
-                WireType wt = (WireType)malloc(sizeof(size_t) + v.length() * sizeof(wchar_t));
-                wt->length = v.length();
-                wmemcpy(wt->data, v.data(), v.length());
-                return wt;
+                return StringWireType<wchar_t>::toWireType(v.data(), v.length());
             }
             static std::wstring fromWireType(WireType v) {
                 return std::wstring(v->data, v->length);
@@ -2,8 +2,21 @@
 /* XXX Emscripten XXX */
 #if __EMSCRIPTEN__
 #define DLMALLOC_EXPORT __attribute__((__weak__, __visibility__("default")))
+/* With -s MALLOC_LARGE_OBJECT_REGION=1, chunks of at least the mmap threshold (256K, or as set with
+   mallopt(M_MMAP_THRESHOLD)) are kept in a region of their own, through the MMAP emulation further below. */
+#ifndef DLMALLOC_LARGE_REGION
+#define DLMALLOC_LARGE_REGION 0
+#endif
+#if DLMALLOC_LARGE_REGION
+#define HAVE_MMAP 1
+#define MMAP_CLEARS 0 /* freed large chunks are reused */
+#define MMAP(s) large_region_map(s)
+#define DIRECT_MMAP(s) large_region_map(s)
+#define MUNMAP(a, s) large_region_unmap((a), (s))
+#else
 /* mmap uses malloc, so malloc can't use mmap */
 #define HAVE_MMAP 0
+#endif
 /* we can only grow the heap up anyhow, so don't try to trim */
 #define MORECORE_CANNOT_TRIM 1
 #ifndef DLMALLOC_DEBUG
@@ -14,12 +27,27 @@
 /* XXX Emscripten Tracing API. This defines away the code if tracing is disabled. */
 #include <emscripten/trace.h>
 
+/* With -s MALLOC_HEAP_PROFILER=1, allocations and frees are reported to the sampling heap profiler in
+   heap_profiler.c. */
+#ifndef DLMALLOC_HEAP_PROFILER
+#define DLMALLOC_HEAP_PROFILER 0
+#endif
+#if DLMALLOC_HEAP_PROFILER
+#include <emscripten/heap_profiler.h>
+#endif
+
 /* Make malloc() and free() threadsafe by securing the memory allocations with pthread mutexes. */
 #if __EMSCRIPTEN_PTHREADS__
 #define USE_LOCKS 1
 #define USE_SPIN_LOCKS 0 // Ensure we use pthread_mutex_t.
 #endif
 
+/* With -s MALLOC_THREAD_CACHE=1, malloc(), calloc() and free() are provided by thread_cache_malloc.c, which keeps
+   per-thread caches of small blocks in front of the dlmalloc(), dlcalloc() and dlfree() defined here. */
+#ifndef DLMALLOC_THREAD_CACHE
+#define DLMALLOC_THREAD_CACHE 0
+#endif
+
 #endif
 
 
@@ -849,10 +877,12 @@ extern "C" {
     
     /* ------------------- Declarations of public routines ------------------- */
     
-#ifndef USE_DL_PREFIX
+#if !defined(USE_DL_PREFIX) && !DLMALLOC_THREAD_CACHE
 #define dlcalloc               calloc
 #define dlfree                 free
 #define dlmalloc               malloc
+#endif
+#ifndef USE_DL_PREFIX
 #define dlmemalign             memalign
 #define dlposix_memalign       posix_memalign
 #define dlrealloc              realloc
@@ -3850,6 +3880,81 @@ if (m == gm) dlfree(mem); else mspace_free(m,mem);
 #endif /* MSPACES */
 #endif /* ONLY_MSPACES */
 
+#if DLMALLOC_LARGE_REGION
+/* ---------------------- Emscripten large chunk region --------------------- */
+
+/*
+ XXX Emscripten: the MMAP calls that dlmalloc makes for large chunks are
+ served from here. Their memory comes from sbrk, apart from the segments
+ of the main heap, and when freed it goes on an address-ordered list that
+ coalesces neighbours. Later large chunks reuse it, so that a large
+ transient buffer neither leaves a hole in the main heap that small
+ chunks then split up, nor makes the heap grow again the next time.
+ Free memory that ends at the top of the heap is given back to sbrk.
+ */
+
+typedef struct large_free_region {
+    size_t size;
+    struct large_free_region* next;
+} large_free_region;
+
+static large_free_region* large_free_regions = 0; /* sorted by address */
+
+static void* large_region_map(size_t size) {
+    void* mem = MFAIL;
+    large_free_region** link;
+    ACQUIRE_MALLOC_GLOBAL_LOCK();
+    for (link = &large_free_regions; *link != 0; link = &(*link)->next) {
+        large_free_region* r = *link;
+        if (r->size == size) {
+            *link = r->next;
+            mem = r;
+            break;
+        }
+        if (r->size > size) {
+            /* Use the end of the free region, so it stays where it is in the list. */
+            r->size -= size;
+            mem = (char*)r + r->size;
+            break;
+        }
+    }
+    if (mem == MFAIL)
+        mem = sbrk(size);
+    RELEASE_MALLOC_GLOBAL_LOCK();
+    return mem;
+}
+
+static int large_region_unmap(void* ptr, size_t size) {
+    large_free_region* r = (large_free_region*)ptr;
+    large_free_region* prev = 0;
+    large_free_region** link;
+    ACQUIRE_MALLOC_GLOBAL_LOCK();
+    for (link = &large_free_regions; *link != 0 && *link < r; link = &(*link)->next)
+        prev = *link;
+    r->size = size;
+    r->next = *link;
+    *link = r;
+    if (r->next != 0 && (char*)r + r->size == (char*)r->next) {
+        r->size += r->next->size;
+        r->next = r->next->next;
+    }
+    if (prev != 0 && (char*)prev + prev->size == (char*)r) {
+        prev->size += r->size;
+        prev->next = r->next;
+        r = prev;
+    }
+    if (r->next == 0 && (char*)r + r->size == (char*)sbrk(0)) {
+        /* The last free region is at the top of the heap; unlink it and lower the top. */
+        for (link = &large_free_regions; *link != r; link = &(*link)->next)
+            ;
+        *link = 0;
+        sbrk(-(intptr_t)r->size);
+    }
+    RELEASE_MALLOC_GLOBAL_LOCK();
+    return 0;
+}
+#endif /* DLMALLOC_LARGE_REGION */
+
 /* -----------------------  Direct-mmapping chunks ----------------------- */
 
 /*
@@ -4667,6 +4772,13 @@ void* dlmalloc(size_t bytes) {
             nb = MAX_SIZE_T; /* Too big to allocate. Force failure (in sys alloc) */
         else {
             nb = pad_request(bytes);
+#if DLMALLOC_LARGE_REGION
+            /* XXX Emscripten: large chunks always come from their own region, not just when the heap is full */
+            ensure_initialization();
+            if (nb >= mparams.mmap_threshold && use_mmap(gm) && (mem = mmap_alloc(gm, nb)) != 0) {
+                goto postaction;
+            }
+#endif
             if (gm->treemap != 0 && (mem = tmalloc_large(gm, nb)) != 0) {
                 check_malloced_chunk(gm, mem, nb);
                 goto postaction;
@@ -4712,6 +4824,9 @@ void* dlmalloc(size_t bytes) {
 #if __EMSCRIPTEN__
         /* XXX Emscripten Tracing API. */
         emscripten_trace_record_allocation(mem, bytes);
+#endif
+#if DLMALLOC_HEAP_PROFILER
+        emscripten_heap_profiler_record_allocation(mem, bytes);
 #endif
         return mem;
     }
@@ -4732,6 +4847,9 @@ void dlfree(void* mem) {
 #if __EMSCRIPTEN__
         /* XXX Emscripten Tracing API. */
         emscripten_trace_record_free(mem);
+#endif
+#if DLMALLOC_HEAP_PROFILER
+        emscripten_heap_profiler_record_free(mem);
 #endif
         mchunkptr p  = mem2chunk(mem);
 #if FOOTERS
@@ -5259,6 +5377,10 @@ void* dlrealloc(void* oldmem, size_t bytes) {
             if (newp != 0) {
                 check_inuse_chunk(m, newp);
                 mem = chunk2mem(newp);
+#if DLMALLOC_HEAP_PROFILER
+                /* Resized in place; moves go through dlmalloc and dlfree below, which report themselves. */
+                emscripten_heap_profiler_record_reallocation(oldmem, mem, bytes);
+#endif
             }
             else {
                 mem = internal_malloc(m, bytes);
@@ -5301,6 +5423,9 @@ void* dlrealloc_in_place(void* oldmem, size_t bytes) {
                 if (newp == oldp) {
                     check_inuse_chunk(m, newp);
                     mem = oldmem;
+#if DLMALLOC_HEAP_PROFILER
+                    emscripten_heap_profiler_record_reallocation(oldmem, mem, bytes);
+#endif
                 }
             }
         }
@@ -6028,9 +6153,14 @@ int mspace_mallopt(int param_number, int value) {
 // and dlfree from this file.
 // This allows an easy mechanism for hooking into memory allocation.
 #if defined(__EMSCRIPTEN__) && !ONLY_MSPACES
+#if DLMALLOC_THREAD_CACHE
+extern __typeof(malloc) emscripten_builtin_malloc __attribute__((weak, alias("dlmalloc")));
+extern __typeof(free) emscripten_builtin_free __attribute__((weak, alias("dlfree")));
+#else
 extern __typeof(malloc) emscripten_builtin_malloc __attribute__((weak, alias("malloc")));
 extern __typeof(free) emscripten_builtin_free __attribute__((weak, alias("free")));
 #endif
+#endif
 
 /* -------------------- Alternative MORECORE functions ------------------- */
 
@@ -13,6 +13,14 @@
 
 using namespace emscripten;
 
+namespace emscripten {
+    namespace internal {
+        static size_t stringArenaStorage[16 * 1024 / sizeof(size_t)];
+        // Empty until it has been registered with JavaScript below.
+        StringArena stringArena = { (char*)stringArenaStorage, 0, 0, 0 };
+    }
+}
+
 extern "C" {
     const char* __attribute__((used)) __getTypeName(const std::type_info* ti) {
         if (has_unbound_type_names) {
@@ -114,8 +122,11 @@ EMSCRIPTEN_BINDINGS(native_and_builtin_types) {
 
     _embind_register_std_string(TypeID<std::string>::get(), "std::string");
     _embind_register_std_string(TypeID<std::basic_string<unsigned char> >::get(), "std::basic_string<unsigned char>");
+    _embind_register_std_string(TypeID<std::string_view>::get(), "std::string_view");
     _embind_register_std_wstring(TypeID<std::wstring>::get(), sizeof(wchar_t), "std::wstring");
     _embind_register_emval(TypeID<val>::get(), "emscripten::val");
+    internal::stringArena.capacity = sizeof(internal::stringArenaStorage);
+    _embind_register_string_arena(&internal::stringArena);
 
     // Some of these types are aliases for each other. Luckily,
     // embind.js's _embind_register_memory_view ignores duplicate
@@ -24,6 +24,13 @@ extern "C" {
 #define INODE_FILE 1
 #define INODE_DIR  2
 
+// File contents are stored in a table of fixed-size pages, so that growing a file only allocates the newly
+// appended pages instead of reallocating and copying the whole file. Pages that have never been written to
+// are not allocated at all (holes), and read back as zeroes.
+#define INODE_PAGE_SIZE_LOG2 12
+#define INODE_PAGE_SIZE (1U << INODE_PAGE_SIZE_LOG2)
+#define INODE_PAGE_MASK (INODE_PAGE_SIZE - 1)
+
 struct inode
 {
 	char name[NAME_MAX+1]; // NAME_MAX actual bytes + one byte for null termination.
@@ -37,8 +44,9 @@ struct inode
 	time_t mtime; // Time when the content was last modified
 	time_t atime; // Time when the content was last accessed
 	size_t size; // Size of the file in bytes
-	size_t capacity; // Amount of bytes allocated to pointer data
-	uint8_t *data; // The actual file contents.
+	size_t num_pages; // Number of entries in the page table 'pages'
+	uint8_t **pages; // The actual file contents, in INODE_PAGE_SIZE sized pages. A null page is a hole that reads as zeroes.
+	bool local_contents; // True if the file was created, truncated or written locally, so its contents must not be fetched.
 
 	INODE_TYPE type;
 
@@ -121,8 +129,84 @@ static void inode_abspath(inode *node, char *dst, int dstLen)
 	}
 }
 
+// Makes sure that the page table of the given inode has room for at least numPages pages. Only the page table
+// (an array of pointers) is reallocated, the file contents themselves are never moved.
+static bool inode_reserve_pages(inode *node, size_t numPages)
+{
+	if (node->num_pages >= numPages) return true;
+	size_t newNumPages = node->num_pages * 2; // Geometric increases in size for amortized O(1) behavior
+	if (newNumPages < numPages) newNumPages = numPages;
+	uint8_t **newPages = (uint8_t **)realloc(node->pages, newNumPages * sizeof(uint8_t *));
+	if (!newPages) return false;
+	memset(newPages + node->num_pages, 0, (newNumPages - node->num_pages) * sizeof(uint8_t *));
+	node->pages = newPages;
+	node->num_pages = newNumPages;
+	return true;
+}
+
+static void inode_free_pages(inode *node)
+{
+	for(size_t i = 0; i < node->num_pages; ++i) free(node->pages[i]);
+	free(node->pages);
+	node->pages = 0;
+	node->num_pages = 0;
+}
+
+// Copies numBytes of file contents starting at the given offset to dst. Holes in the file read as zeroes.
+// The caller is responsible for clamping the read to the size of the file.
+static void inode_read(inode *node, size_t offset, uint8_t *dst, size_t numBytes)
+{
+	while(numBytes > 0)
+	{
+		size_t page = offset >> INODE_PAGE_SIZE_LOG2;
+		size_t pageOffset = offset & INODE_PAGE_MASK;
+		size_t n = INODE_PAGE_SIZE - pageOffset;
+		if (n > numBytes) n = numBytes;
+		uint8_t *pageData = (page < node->num_pages) ? node->pages[page] : 0;
+		if (pageData) memcpy(dst, pageData + pageOffset, n);
+		else memset(dst, 0, n);
+		dst += n;
+		offset += n;
+		numBytes -= n;
+	}
+}
+
+// Writes numBytes from src to the file contents at the given offset, allocating pages as needed. Returns the number
+// of bytes written, which is less than numBytes only if running out of memory.
+static size_t inode_write(inode *node, size_t offset, const uint8_t *src, size_t numBytes)
+{
+	if (numBytes == 0) return 0;
+	if (!inode_reserve_pages(node, ((offset + numBytes - 1) >> INODE_PAGE_SIZE_LOG2) + 1)) return 0;
+	node->local_contents = true;
+
+	size_t written = 0;
+	while(written < numBytes)
+	{
+		size_t page = offset >> INODE_PAGE_SIZE_LOG2;
+		size_t pageOffset = offset & INODE_PAGE_MASK;
+		size_t n = INODE_PAGE_SIZE - pageOffset;
+		if (n > numBytes - written) n = numBytes - written;
+		uint8_t *pageData = node->pages[page];
+		if (!pageData)
+		{
+			pageData = (uint8_t *)malloc(INODE_PAGE_SIZE);
+			if (!pageData) break;
+			// Zero the parts of the new page that this write does not cover, so that gaps read back as zeroes.
+			memset(pageData, 0, pageOffset);
+			memset(pageData + pageOffset + n, 0, INODE_PAGE_SIZE - pageOffset - n);
+			node->pages[page] = pageData;
+		}
+		memcpy(pageData + pageOffset, src + written, n);
+		offset += n;
+		written += n;
+	}
+	if (offset > node->size) node->size = offset;
+	return written;
+}
+
 static void delete_inode(inode *node)
 {
+	inode_free_pages(node);
 	free(node);
 }
 
@@ -548,31 +632,139 @@ void emscripten_dump_fs_root()
 		return -errno; \
 	} while(0)
 
-static char stdout_buffer[4096] = {};
-static int stdout_buffer_end = 0;
-static char stderr_buffer[4096] = {};
-static int stderr_buffer_end = 0;
+// Output written to stdout and stderr is collected to a bounded buffer per stream, and complete lines are handed
+// over to Module['print']/Module['printErr'] in batches, so that printf-heavy programs pay one JS call and one
+// string decode per batch instead of per line. stdout is flushed when STDIO_FLUSH_THRESHOLD bytes of complete
+// lines have accumulated, when STDIO_FLUSH_INTERVAL_MSECS has passed since the last flush, on fsync() and at exit.
+// stderr is flushed after each write, since it is expected to be unbuffered.
+#define STDIO_BUFFER_SIZE 65536
+#define STDIO_FLUSH_THRESHOLD 16384
+#define STDIO_FLUSH_INTERVAL_MSECS 100.0
+
+struct print_buffer
+{
+	char data[STDIO_BUFFER_SIZE];
+	int end; // Number of bytes currently in the buffer
+	int lines_end; // Number of bytes in the buffer up to and including the last newline, i.e. the complete lines
+	double last_flush_time;
+};
+
+static print_buffer stdout_buffer = {};
+static print_buffer stderr_buffer = {};
+static volatile int print_buffer_lock = 0;
+static bool print_buffer_timer_pending = false;
+static bool print_buffer_atexit_registered = false;
+
+static void lock_print_buffers()
+{
+	while(__sync_lock_test_and_set(&print_buffer_lock, 1)) /* spin */;
+}
+
+static void unlock_print_buffers()
+{
+	__sync_lock_release(&print_buffer_lock);
+}
+
+static void print_batch(const char *batch, int numBytes, bool complete_lines, bool stdout)
+{
+	EM_ASM({
+		// The batch is not null-terminated, so decode it by its length.
+		var lines = UTF8ArrayToString(HEAPU8.subarray($0, $0 + $1), 0).split('\n');
+		if ($2) lines.pop(); // The text ends in a newline, so the last element is an empty string.
+		var print = $3 ? Module['print'] : Module['printErr'];
+		for(var i = 0; i < lines.length; ++i) print(lines[i]);
+	}, batch, numBytes, complete_lines, stdout);
+}
+
+static void consume_print_buffer(print_buffer *buffer, int numBytes)
+{
+	memmove(buffer->data, buffer->data + numBytes, buffer->end - numBytes);
+	buffer->end -= numBytes;
+	buffer->lines_end = 0;
+}
+
+// Hands the complete lines in the buffer (or everything, if partial_line is true) to JS in a single call.
+// Must be called with the print buffer lock held. The batch is copied out and the lock released while JS prints it,
+// so that slow output handlers do not hold up other threads writing output.
+static void flush_print_buffer(print_buffer *buffer, bool stdout, bool partial_line)
+{
+	buffer->last_flush_time = emscripten_get_now();
+	int numBytes = partial_line ? buffer->end : buffer->lines_end;
+	if (numBytes <= 0) return;
+	bool complete_lines = numBytes == buffer->lines_end;
+	char *batch = (char *)malloc(numBytes);
+	if (!batch)
+	{
+		// No memory for a copy, so print straight from the buffer while still holding the lock.
+		print_batch(buffer->data, numBytes, complete_lines, stdout);
+		consume_print_buffer(buffer, numBytes);
+		return;
+	}
+	memcpy(batch, buffer->data, numBytes);
+	consume_print_buffer(buffer, numBytes);
+	unlock_print_buffers();
+	print_batch(batch, numBytes, complete_lines, stdout);
+	free(batch);
+	lock_print_buffers();
+}
+
+EMSCRIPTEN_KEEPALIVE void emscripten_asmfs_flush_stdio(int partial_lines)
+{
+	lock_print_buffers();
+	print_buffer_timer_pending = false;
+	flush_print_buffer(&stdout_buffer, true, partial_lines);
+	flush_print_buffer(&stderr_buffer, false, partial_lines);
+	unlock_print_buffers();
+}
+
+static void flush_stdio_at_exit()
+{
+	fflush(0); // Let libc push its own stdio buffers to us first.
+	emscripten_asmfs_flush_stdio(1);
+}
 
 static void print_stream(void *bytes, int numBytes, bool stdout)
 {
-	char *buffer = stdout ? stdout_buffer : stderr_buffer;
-	int &buffer_end = stdout ? stdout_buffer_end : stderr_buffer_end;
+	const char *src = (const char *)bytes;
+	lock_print_buffers();
+	print_buffer *buffer = stdout ? &stdout_buffer : &stderr_buffer;
 
-	memcpy(buffer + buffer_end, bytes, numBytes);
-	buffer_end += numBytes;
-	int new_buffer_start = 0;
-	for(int i = 0; i < buffer_end; ++i)
+	// Keep the relative order of stdout and stderr output.
+	if (!stdout) flush_print_buffer(&stdout_buffer, true, false);
+
+	while(numBytes > 0)
 	{
-		if (buffer[i] == '\n')
+		if (buffer->end == STDIO_BUFFER_SIZE)
 		{
-			buffer[i] = 0;
-			EM_ASM_INT( { Module['print'](Pointer_stringify($0)) }, buffer+new_buffer_start);
-			new_buffer_start = i+1;
+			// Out of space: flush the complete lines, or if the buffer holds only one very long line, break it.
+			flush_print_buffer(buffer, stdout, buffer->lines_end == 0);
 		}
+		int n = STDIO_BUFFER_SIZE - buffer->end;
+		if (n > numBytes) n = numBytes;
+		memcpy(buffer->data + buffer->end, src, n);
+		for(int i = n-1; i >= 0; --i)
+			if (src[i] == '\n')
+			{
+				buffer->lines_end = buffer->end + i + 1;
+				break;
+			}
+		buffer->end += n;
+		src += n;
+		numBytes -= n;
 	}
-	size_t new_buffer_size = buffer_end - new_buffer_start;
-	memmove(buffer, buffer + new_buffer_start, new_buffer_size);
-	buffer_end = new_buffer_size;
+
+	if (!stdout || buffer->lines_end >= STDIO_FLUSH_THRESHOLD || emscripten_get_now() - buffer->last_flush_time >= STDIO_FLUSH_INTERVAL_MSECS)
+		flush_print_buffer(buffer, stdout, false);
+
+	// If some output is left over, make sure it gets printed even if the program stops writing to stdout.
+	bool schedule_timer = stdout_buffer.end > 0 && !print_buffer_timer_pending;
+	if (schedule_timer) print_buffer_timer_pending = true;
+	bool register_atexit = !print_buffer_atexit_registered;
+	print_buffer_atexit_registered = true;
+	unlock_print_buffers();
+
+	if (schedule_timer) EM_ASM(setTimeout(function() { Module['_emscripten_asmfs_flush_stdio'](0) }, $0), (int)STDIO_FLUSH_INTERVAL_MSECS);
+	if (register_atexit) atexit(flush_stdio_at_exit);
 }
 
 long __syscall3(int which, ...) // read
@@ -675,17 +867,20 @@ static long open(const char *pathname, int flags, int mode)
 		{
 			if (node->fetch) emscripten_fetch_close(node->fetch);
 			node->fetch = 0;
+			inode_free_pages(node);
 			node->size = 0;
+			node->local_contents = true;
 		}
 		else if ((flags & O_CREAT))
 		{
 			inode *directory = create_directory_hierarchy_for_file(root, relpath, mode);
 			node = create_inode((flags & O_DIRECTORY) ? INODE_DIR : INODE_FILE, mode);
 			strcpy(node->name, basename_part(pathname));
+			node->local_contents = true;
 			link_inode(node, directory);
 		}
 	}
-	else if (!node || (node->type == INODE_FILE && !node->fetch && !node->data))
+	else if (!node || (node->type == INODE_FILE && !node->fetch && !node->local_contents))
 	{
 		emscripten_fetch_t *fetch = 0;
 		if (!(flags & O_DIRECTORY) && accessMode != O_WRONLY)
@@ -742,7 +937,7 @@ static long open(const char *pathname, int flags, int mode)
 	FileDescriptor *desc = (FileDescriptor*)malloc(sizeof(FileDescriptor));
 	desc->magic = EM_FILEDESCRIPTOR_MAGIC;
 	desc->node = node;
-	desc->file_pos = ((flags & O_APPEND) && node->fetch) ? node->fetch->totalBytes : 0;
+	desc->file_pos = (flags & O_APPEND) ? (node->fetch ? node->fetch->totalBytes : node->size) : 0;
 	desc->mode = mode;
 	desc->flags = flags;
 
@@ -1088,6 +1283,12 @@ long __syscall118(int which, ...) // fsync
 	unsigned int fd = va_arg(vl, unsigned int);
 	va_end(vl);
 
+	if (fd == 1/*stdout*/ || fd == 2/*stderr*/) // TODO: Resolve the hardcoding of stdin,stdout & stderr
+	{
+		emscripten_asmfs_flush_stdio(1);
+		return 0;
+	}
+
 	FileDescriptor *desc = (FileDescriptor*)fd;
 	if (!desc || desc->magic != EM_FILEDESCRIPTOR_MAGIC) RETURN_ERRNO(EBADF, "fd isn't a valid open file descriptor");
 
@@ -1164,7 +1365,7 @@ long __syscall145(int which, ...) // readv
 
 	if (node->fetch) emscripten_fetch_wait(node->fetch, INFINITY);
 
-	if (node->size > 0 && !node->data && (!node->fetch || !node->fetch->data)) RETURN_ERRNO(-1, "ASMFS internal error: no file data available");
+	if (node->size > 0 && !node->pages && (!node->fetch || !node->fetch->data)) RETURN_ERRNO(-1, "ASMFS internal error: no file data available");
 	if (iovcnt < 0) RETURN_ERRNO(EINVAL, "The vector count, iovcnt, is less than zero");
 
 	ssize_t total_read_amount = 0;
@@ -1177,13 +1378,14 @@ long __syscall145(int which, ...) // readv
 	}
 
 	size_t offset = desc->file_pos;
-	uint8_t *data = node->data ? node->data : (node->fetch ? (uint8_t *)node->fetch->data : 0);
+	uint8_t *fetchData = (!node->pages && node->fetch) ? (uint8_t *)node->fetch->data : 0;
 	for(int i = 0; i < iovcnt; ++i)
 	{
 		ssize_t dataLeft = node->size - offset;
 		if (dataLeft <= 0) break;
 		size_t bytesToCopy = (size_t)dataLeft < iov[i].iov_len ? dataLeft : iov[i].iov_len;
-		memcpy(iov[i].iov_base, &data[offset], bytesToCopy);
+		if (fetchData) memcpy(iov[i].iov_base, &fetchData[offset], bytesToCopy);
+		else inode_read(node, offset, (uint8_t *)iov[i].iov_base, bytesToCopy);
 		offset += bytesToCopy;
 	}
 	ssize_t numRead = offset - desc->file_pos;
@@ -1230,32 +1432,23 @@ long __syscall146(int which, ...) // writev
 	}
 	else
 	{
-		// Enlarge the file in memory to fit space for the new data
-		size_t newSize = desc->file_pos + total_write_amount;
+		// Scatter the new data into the pages of the file. Only pages that are touched for the first time get
+		// allocated, so growing a file costs O(appended bytes), and seeking past the end leaves a hole of zeroes.
 		inode *node = desc->node;
-		if (node->capacity < newSize)
+		ssize_t bytesWritten = 0;
+		for(int i = 0; i < iovcnt; ++i)
 		{
-			size_t newCapacity = (newSize > (size_t)(node->capacity*1.25) ? newSize : (size_t)(node->capacity*1.25)); // Geometric increases in size for amortized O(1) behavior
-			uint8_t *newData = (uint8_t *)realloc(node->data, newCapacity);
-			if (!newData)
+			size_t n = inode_write(node, desc->file_pos, (const uint8_t *)iov[i].iov_base, iov[i].iov_len);
+			desc->file_pos += n;
+			bytesWritten += n;
+			if (n < iov[i].iov_len)
 			{
-				newData = (uint8_t *)malloc(newCapacity);
-				memcpy(newData, node->data, node->size);
-				// TODO: init gaps with zeroes.
-				free(node->data);
+				if (bytesWritten == 0) RETURN_ERRNO(ENOSPC, "The device containing the file referred to by fd has no room for the data");
+				break;
 			}
-			node->data = newData;
-			node->size = newSize;
-			node->capacity = newCapacity;
-		}
-
-		for(int i = 0; i < iovcnt; ++i)
-		{
-			memcpy((uint8_t*)node->data + desc->file_pos, iov[i].iov_base, iov[i].iov_len);
-			desc->file_pos += iov[i].iov_len;
 		}
+		return bytesWritten;
 	}
-	return total_write_amount;
 }
 
 // TODO: syscall148: fdatasync
@@ -7,39 +7,86 @@
 #include <emscripten/emscripten.h>
 #include <math.h>
 
-struct __emscripten_fetch_queue
+// Proxied fetches are handed over to the fetch worker through a set of ring buffers in shared memory, one per
+// priority class. Any number of threads may enqueue, and the fetch worker is the single consumer. Both sides
+// serialize access with the spinlock 'lock'. The memory layout of these structures is mirrored in src/Fetch.js.
+struct __emscripten_fetch_ring
 {
 	emscripten_fetch_t **queuedOperations;
-	int numQueuedItems;
-	int queueSize;
+	uint32_t head; // Index of the next item the fetch worker will pick up. (free running, wraps around at 2^32)
+	uint32_t tail; // Index where the next item will be enqueued. (free running, wraps around at 2^32)
+	uint32_t queueSize; // Capacity of queuedOperations, always a power of two.
+};
+
+struct __emscripten_fetch_queue
+{
+	__emscripten_fetch_ring rings[EMSCRIPTEN_FETCH_NUM_PRIORITIES];
+	uint32_t lock;
+	uint32_t maxInFlight; // Maximum number of fetches the fetch worker runs concurrently, or 0 for no limit.
 };
 
 extern "C" {
 	void emscripten_start_fetch(emscripten_fetch_t *fetch);
 	__emscripten_fetch_queue *_emscripten_get_fetch_work_queue();
+}
 
-	__emscripten_fetch_queue *_emscripten_get_fetch_queue()
-	{
-		__emscripten_fetch_queue *queue = _emscripten_get_fetch_work_queue();
-		if (!queue->queuedOperations)
-		{
-			queue->queueSize = 64;
-			queue->numQueuedItems = 0;
-			queue->queuedOperations = (emscripten_fetch_t**)malloc(sizeof(emscripten_fetch_t*) * queue->queueSize);
-		}
-		return queue;
-	}
+static void lock_fetch_queue(__emscripten_fetch_queue *queue)
+{
+	while(emscripten_atomic_cas_u32(&queue->lock, 0, 1) != 0) /* spin */;
+}
+
+static void unlock_fetch_queue(__emscripten_fetch_queue *queue)
+{
+	emscripten_atomic_store_u32(&queue->lock, 0);
 }
 
-void emscripten_proxy_fetch(emscripten_fetch_t *fetch)
+static int fetch_priority(const emscripten_fetch_t *fetch)
 {
-	// TODO: mutex lock
-	__emscripten_fetch_queue *queue = _emscripten_get_fetch_queue();
-//	TODO handle case when queue->numQueuedItems >= queue->queueSize
-	queue->queuedOperations[queue->numQueuedItems++] = fetch;
+	if ((fetch->__attributes.attributes & EMSCRIPTEN_FETCH_PRIORITY_HIGH)) return 0;
+	if ((fetch->__attributes.attributes & EMSCRIPTEN_FETCH_PRIORITY_LOW)) return 2;
+	return 1;
+}
+
+// Doubles the capacity of the given ring, keeping the queued items in order. Must be called with the queue lock held.
+static bool grow_fetch_ring(__emscripten_fetch_ring *ring)
+{
+	uint32_t newSize = ring->queueSize ? ring->queueSize * 2 : 64;
+	emscripten_fetch_t **newOperations = (emscripten_fetch_t**)malloc(sizeof(emscripten_fetch_t*) * newSize);
+	if (!newOperations) return false;
+	uint32_t numQueuedItems = ring->tail - ring->head;
+	for(uint32_t i = 0; i < numQueuedItems; ++i)
+		newOperations[i] = ring->queuedOperations[(ring->head + i) & (ring->queueSize - 1)];
+	free(ring->queuedOperations);
+	ring->queuedOperations = newOperations;
+	ring->head = 0;
+	ring->tail = numQueuedItems;
+	ring->queueSize = newSize;
+	return true;
+}
+
+void emscripten_fetch_set_max_in_flight(unsigned int maxInFlight)
+{
+	__emscripten_fetch_queue *queue = _emscripten_get_fetch_work_queue();
+	emscripten_atomic_store_u32(&queue->maxInFlight, maxInFlight);
+}
+
+static bool emscripten_proxy_fetch(emscripten_fetch_t *fetch)
+{
+	__emscripten_fetch_queue *queue = _emscripten_get_fetch_work_queue();
+	__emscripten_fetch_ring *ring = &queue->rings[fetch_priority(fetch)];
+	lock_fetch_queue(queue);
+	if (ring->tail - ring->head >= ring->queueSize && !grow_fetch_ring(ring))
+	{
+		unlock_fetch_queue(queue);
+		return false;
+	}
+	ring->queuedOperations[ring->tail & (ring->queueSize - 1)] = fetch;
+	++ring->tail;
+	uint32_t numQueuedItems = ring->tail - ring->head;
+	unlock_fetch_queue(queue);
 	EM_ASM(console.log('Queued fetch to fetch-worker to process. There are now ' + $0 + ' operations in the queue.'),
-		queue->numQueuedItems);
-	// TODO: mutex unlock
+		numQueuedItems);
+	return true;
 }
 
 void emscripten_fetch_attr_init(emscripten_fetch_attr_t *fetch_attr)
@@ -47,7 +94,7 @@ void emscripten_fetch_attr_init(emscripten_fetch_attr_t *fetch_attr)
 	memset(fetch_attr, 0, sizeof(emscripten_fetch_attr_t));
 }
 
-static int globalFetchIdCounter = 1;
+static uint32_t globalFetchIdCounter = 1;
 emscripten_fetch_t *emscripten_fetch(emscripten_fetch_attr_t *fetch_attr, const char *url)
 {
 	if (!fetch_attr) return 0;
@@ -68,7 +115,7 @@ emscripten_fetch_t *emscripten_fetch(emscripten_fetch_attr_t *fetch_attr, const
 
 	emscripten_fetch_t *fetch = (emscripten_fetch_t *)malloc(sizeof(emscripten_fetch_t));
 	memset(fetch, 0, sizeof(emscripten_fetch_t));
-	fetch->id = globalFetchIdCounter++; // TODO: make this thread-safe!
+	fetch->id = __sync_fetch_and_add(&globalFetchIdCounter, 1);
 	fetch->userData = fetch_attr->userData;
 	fetch->url = strdup(url); // TODO: free
 	fetch->__attributes = *fetch_attr;
@@ -87,7 +134,13 @@ emscripten_fetch_t *emscripten_fetch(emscripten_fetch_attr_t *fetch_attr, const
 		|| (synchronous && (readFromIndexedDB || writeToIndexedDB))) // Synchronous IndexedDB access needs proxying
 	{
 		emscripten_atomic_store_u32(&fetch->__proxyState, 1); // sent to proxy worker.
-		emscripten_proxy_fetch(fetch);
+		if (!emscripten_proxy_fetch(fetch))
+		{
+			emscripten_atomic_store_u32(&fetch->__proxyState, 0);
+			free((void*)fetch->url);
+			free(fetch);
+			return 0;
+		}
 
 		if (synchronous) emscripten_fetch_wait(fetch, INFINITY);
 	}
@@ -145,7 +198,7 @@ EMSCRIPTEN_RESULT emscripten_fetch_close(emscripten_fetch_t *fetch)
 		fetch->__attributes.onerror(fetch);
 	}
 	fetch->id = 0;
-	free((void*)fetch->data);
+	if (!fetch->__attributes.destinationBuffer) free((void*)fetch->data); // Destination buffers are owned by the caller.
 	free(fetch);
 	return EMSCRIPTEN_RESULT_SUCCESS;
 }
@@ -0,0 +1,238 @@
+/*
+   Sampling heap profiler, for -s MALLOC_HEAP_PROFILER=1
+
+   dlmalloc reports every allocation, in-place reallocation and free here. Allocations are sampled on average once
+   per sample interval of bytes allocated (with exponentially distributed gaps, as tcmalloc does, so that periodic
+   allocation patterns do not bias the samples), which keeps the cost of the common allocation down to a subtraction. A sampled allocation has
+   its JS call stack captured, and is aggregated with others from the same stack. Live samples are remembered until
+   they are freed, so the profile shows both what is in use now and what has been allocated in total.
+
+   emscripten_heap_profiler_dump() writes the result in the legacy pprof heap profile format (heap_v2, which pprof
+   unsamples using the interval), with a symbol table for the stack frames embedded so no binary is needed.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <emscripten.h>
+#include <emscripten/heap_profiler.h>
+
+#define MAX_FRAMES 16
+#define MAX_SITES 1024 // Must be a power of 2.
+#define MAX_LIVE_SAMPLES 8192 // Must be a power of 2.
+#define DEFAULT_SAMPLE_INTERVAL (512*1024)
+
+// Synthetic addresses for the frames of a stack. pprof looks up callers at their address minus one, so symbols are
+// spaced apart and written for both.
+#define FRAME_ADDRESS(id) ((uint32_t)(id) << 4)
+
+int emscripten_heap_profiler_capture_stack(int *frames, int max_frames);
+int emscripten_heap_profiler_get_symbol(int id, char *out, int maxbytes);
+
+typedef struct site
+{
+	uint32_t hash;
+	int num_frames; // -1 for an unused entry.
+	int frames[MAX_FRAMES];
+	size_t alloc_count, alloc_bytes;
+	size_t live_count, live_bytes;
+} site;
+
+typedef struct live_sample
+{
+	const void *address; // 0 for an unused entry.
+	size_t size;
+	site *site;
+} live_sample;
+
+static site sites[MAX_SITES];
+static live_sample live_samples[MAX_LIVE_SAMPLES];
+static size_t num_live_samples = 0;
+static int initialized = 0;
+static int in_profiler = 0; // Set while the profiler itself allocates, e.g. in stdio when dumping.
+
+static size_t sample_interval = DEFAULT_SAMPLE_INTERVAL;
+static intptr_t bytes_until_sample = DEFAULT_SAMPLE_INTERVAL;
+static uint32_t random_state = 0x9E3779B9u;
+
+static void initialize()
+{
+	for(int i = 0; i < MAX_SITES; ++i)
+		sites[i].num_frames = -1;
+	initialized = 1;
+}
+
+static intptr_t next_sample_gap()
+{
+	// xorshift32, then an exponentially distributed gap with the sample interval as its mean.
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	double u = (random_state >> 8) * (1.0 / 16777216.0) + (0.5 / 16777216.0);
+	double gap = -log(u) * sample_interval;
+	return gap < 1 ? 1 : gap > INTPTR_MAX / 2 ? INTPTR_MAX / 2 : (intptr_t)gap;
+}
+
+static uint32_t hash_frames(const int *frames, int num_frames)
+{
+	uint32_t hash = 2166136261u; // FNV-1a
+	for(int i = 0; i < num_frames; ++i)
+	{
+		hash ^= (uint32_t)frames[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static site *find_site(const int *frames, int num_frames)
+{
+	uint32_t hash = hash_frames(frames, num_frames);
+	for(uint32_t i = 0; i < MAX_SITES; ++i)
+	{
+		site *s = &sites[(hash + i) & (MAX_SITES - 1)];
+		if (s->num_frames < 0)
+		{
+			s->hash = hash;
+			s->num_frames = num_frames;
+			memcpy(s->frames, frames, num_frames * sizeof(int));
+			return s;
+		}
+		if (s->hash == hash && s->num_frames == num_frames && !memcmp(s->frames, frames, num_frames * sizeof(int)))
+			return s;
+	}
+	return 0; // Full: further new stacks are not profiled.
+}
+
+static uint32_t address_slot(const void *address)
+{
+	return ((uint32_t)(uintptr_t)address * 2654435761u) >> 19; // log2(MAX_LIVE_SAMPLES) high bits of the product.
+}
+
+static void add_live_sample(const void *address, size_t size, site *s)
+{
+	if (num_live_samples >= MAX_LIVE_SAMPLES / 2) return; // Keep probe sequences short; the sample counts as dead.
+	uint32_t i = address_slot(address);
+	while(live_samples[i].address)
+		i = (i + 1) & (MAX_LIVE_SAMPLES - 1);
+	live_samples[i].address = address;
+	live_samples[i].size = size;
+	live_samples[i].site = s;
+	++num_live_samples;
+	++s->live_count;
+	s->live_bytes += size;
+}
+
+static void remove_live_sample(const void *address)
+{
+	uint32_t i = address_slot(address);
+	while(live_samples[i].address != address)
+	{
+		if (!live_samples[i].address) return; // Not sampled.
+		i = (i + 1) & (MAX_LIVE_SAMPLES - 1);
+	}
+	site *s = live_samples[i].site;
+	--s->live_count;
+	s->live_bytes -= live_samples[i].size;
+	--num_live_samples;
+
+	// Backward shift deletion, so that linear probing needs no tombstones.
+	uint32_t hole = i;
+	for(;;)
+	{
+		i = (i + 1) & (MAX_LIVE_SAMPLES - 1);
+		if (!live_samples[i].address) break;
+		uint32_t home = address_slot(live_samples[i].address);
+		if (((i - home) & (MAX_LIVE_SAMPLES - 1)) >= ((i - hole) & (MAX_LIVE_SAMPLES - 1)))
+		{
+			live_samples[hole] = live_samples[i];
+			hole = i;
+		}
+	}
+	live_samples[hole].address = 0;
+}
+
+void emscripten_heap_profiler_set_sample_interval(size_t bytes)
+{
+	sample_interval = bytes;
+	bytes_until_sample = bytes ? next_sample_gap() : INTPTR_MAX;
+}
+
+void emscripten_heap_profiler_record_allocation(const void *address, size_t size)
+{
+	if (!address) return;
+	bytes_until_sample -= (intptr_t)size;
+	if (bytes_until_sample > 0 || !sample_interval || in_profiler) return;
+	bytes_until_sample = next_sample_gap();
+
+	if (!initialized) initialize();
+	int frames[MAX_FRAMES];
+	int num_frames = emscripten_heap_profiler_capture_stack(frames, MAX_FRAMES);
+	site *s = find_site(frames, num_frames);
+	if (!s) return;
+	++s->alloc_count;
+	s->alloc_bytes += size;
+	add_live_sample(address, size, s);
+}
+
+void emscripten_heap_profiler_record_free(const void *address)
+{
+	if (num_live_samples) remove_live_sample(address);
+}
+
+// A realloc that resizes in place counts as freeing the old allocation and making the new one, so that the live
+// sample, if any, has the new size and the bytes allocated are sampled like any other allocation.
+void emscripten_heap_profiler_record_reallocation(const void *old_address, const void *address, size_t size)
+{
+	emscripten_heap_profiler_record_free(old_address);
+	emscripten_heap_profiler_record_allocation(address, size);
+}
+
+int emscripten_heap_profiler_dump(const char *path)
+{
+	if (!initialized) initialize();
+	in_profiler = 1;
+	FILE *f = fopen(path, "w");
+	if (!f)
+	{
+		in_profiler = 0;
+		return -1;
+	}
+
+	int max_id = 0;
+	size_t live_count = 0, live_bytes = 0, alloc_count = 0, alloc_bytes = 0;
+	for(int i = 0; i < MAX_SITES; ++i)
+	{
+		site *s = &sites[i];
+		for(int j = 0; j < s->num_frames; ++j)
+			if (s->frames[j] > max_id) max_id = s->frames[j];
+		if (s->num_frames < 0) continue;
+		live_count += s->live_count;
+		live_bytes += s->live_bytes;
+		alloc_count += s->alloc_count;
+		alloc_bytes += s->alloc_bytes;
+	}
+
+	fprintf(f, "--- symbol\nbinary=%s\n", emscripten_run_script_string("Module['thisProgram']"));
+	char name[256];
+	for(int id = 1; id <= max_id; ++id)
+	{
+		emscripten_heap_profiler_get_symbol(id, name, sizeof(name));
+		fprintf(f, "0x%08x %s\n0x%08x %s\n", FRAME_ADDRESS(id) - 1, name, FRAME_ADDRESS(id), name);
+	}
+	fprintf(f, "---\n--- heap\n");
+	fprintf(f, "heap profile: %6zu: %8zu [%6zu: %8zu] @ heap_v2/%zu\n", live_count, live_bytes, alloc_count, alloc_bytes, sample_interval);
+	for(int i = 0; i < MAX_SITES; ++i)
+	{
+		site *s = &sites[i];
+		if (s->num_frames < 0) continue;
+		fprintf(f, "%6zu: %8zu [%6zu: %8zu] @", s->live_count, s->live_bytes, s->alloc_count, s->alloc_bytes);
+		for(int j = 0; j < s->num_frames; ++j)
+			fprintf(f, " 0x%08x", FRAME_ADDRESS(s->frames[j]));
+		fprintf(f, "\n");
+	}
+	int ok = !ferror(f);
+	ok = !fclose(f) && ok;
+	in_profiler = 0;
+	return ok ? 0 : -1;
+}
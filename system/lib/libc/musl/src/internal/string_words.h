@@ -0,0 +1,23 @@
+#ifndef STRING_WORDS_H
+#define STRING_WORDS_H
+
+/* XXX EMSCRIPTEN: helpers for the word-at-a-time string functions. Words are
+ * 64 bits, which wasm handles natively. Loads are only ever made from
+ * word-aligned addresses, as asm.js cannot load from unaligned ones. */
+
+#include <stdint.h>
+#include <limits.h>
+
+typedef uint64_t sword;
+
+#define SW_SIZE (sizeof(sword))
+#define SW_ALIGN (SW_SIZE-1)
+#define SW_ONES ((sword)-1/UCHAR_MAX)
+#define SW_HIGHS (SW_ONES * (UCHAR_MAX/2+1))
+/* Nonzero if x has a zero byte. The lowest set bit is in the first zero
+ * byte; higher ones may be spurious. */
+#define SW_HASZERO(x) (((x)-SW_ONES) & ~(x) & SW_HIGHS)
+/* The index of the first (lowest addressed) byte flagged by SW_HASZERO. */
+#define SW_FIRST(m) (__builtin_ctzll(m) >> 3)
+
+#endif
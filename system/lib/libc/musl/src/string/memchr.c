@@ -1,3 +1,25 @@
+#ifdef __EMSCRIPTEN__
+/* XXX EMSCRIPTEN: 64-bit word at a time. */
+#include <string.h>
+#include "string_words.h"
+
+void *memchr(const void *src, int c, size_t n)
+{
+	const unsigned char *s = src;
+	c = (unsigned char)c;
+	for (; ((uintptr_t)s & SW_ALIGN) && n && *s != c; s++, n--);
+	if (n && *s != c) {
+		const sword *w;
+		sword k = SW_ONES * c, m;
+		for (w = (const void *)s; n>=SW_SIZE; w++, n-=SW_SIZE)
+			if ((m = SW_HASZERO(*w^k))) return (char *)w + SW_FIRST(m);
+		for (s = (const void *)w; n && *s != c; s++, n--);
+	}
+	return n ? (void *)s : 0;
+}
+
+#else
+
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
@@ -21,3 +43,5 @@ void *memchr(const void *src, int c, size_t n)
 	}
 	return n ? (void *)s : 0;
 }
+
+#endif
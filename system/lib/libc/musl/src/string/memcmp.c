@@ -1,8 +1,32 @@
+#ifdef __EMSCRIPTEN__
+/* XXX EMSCRIPTEN: 64-bit word at a time when both buffers are equally aligned. */
 #include <string.h>
+#include "string_words.h"
 
 int memcmp(const void *vl, const void *vr, size_t n)
 {
 	const unsigned char *l=vl, *r=vr;
+	if ((((uintptr_t)l ^ (uintptr_t)r) & SW_ALIGN) == 0) {
+		const sword *wl, *wr;
+		for (; ((uintptr_t)l & SW_ALIGN) && n; n--, l++, r++)
+			if (*l != *r) return *l-*r;
+		for (wl = (const void *)l, wr = (const void *)r; n>=SW_SIZE && *wl == *wr; n-=SW_SIZE, wl++, wr++);
+		l = (const void *)wl;
+		r = (const void *)wr;
+	}
 	for (; n && *l == *r; n--, l++, r++);
 	return n ? *l-*r : 0;
 }
+
+#else
+
+#include <string.h>
+
+int memcmp(const void *vl, const void *vr, size_t n)
+{
+	const unsigned char *l=vl, *r=vr;
+	for (; n && *l == *r; n--, l++, r++);
+	return n ? *l-*r : 0;
+}
+
+#endif
@@ -1,3 +1,28 @@
+#ifdef __EMSCRIPTEN__
+/* XXX EMSCRIPTEN: 64-bit word at a time. */
+#include <string.h>
+#include "libc.h"
+#include "string_words.h"
+
+char *__strchrnul(const char *s, int c)
+{
+	const sword *w;
+	sword k, m;
+
+	c = (unsigned char)c;
+	if (!c) return (char *)s + strlen(s);
+
+	for (; (uintptr_t)s & SW_ALIGN; s++)
+		if (!*s || *(unsigned char *)s == c) return (char *)s;
+	k = SW_ONES * c;
+	for (w = (const void *)s; !(m = SW_HASZERO(*w) | SW_HASZERO(*w^k)); w++);
+	return (char *)w + SW_FIRST(m);
+}
+
+weak_alias(__strchrnul, strchrnul);
+
+#else
+
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
@@ -24,3 +49,5 @@ char *__strchrnul(const char *s, int c)
 }
 
 weak_alias(__strchrnul, strchrnul);
+
+#endif
@@ -1,7 +1,30 @@
+#ifdef __EMSCRIPTEN__
+/* XXX EMSCRIPTEN: 64-bit word at a time when both strings are equally aligned. */
 #include <string.h>
+#include "string_words.h"
 
 int strcmp(const char *l, const char *r)
 {
+	if ((((uintptr_t)l ^ (uintptr_t)r) & SW_ALIGN) == 0) {
+		const sword *wl, *wr;
+		for (; (uintptr_t)l & SW_ALIGN; l++, r++)
+			if (*l != *r || !*l) return *(unsigned char *)l - *(unsigned char *)r;
+		for (wl = (const void *)l, wr = (const void *)r; *wl == *wr && !SW_HASZERO(*wl); wl++, wr++);
+		l = (const void *)wl;
+		r = (const void *)wr;
+	}
 	for (; *l==*r && *l; l++, r++);
 	return *(unsigned char *)l - *(unsigned char *)r;
 }
+
+#else
+
+#include <string.h>
+
+int strcmp(const char *l, const char *r)
+{
+	for (; *l==*r && *l; l++, r++);
+	return *(unsigned char *)l - *(unsigned char *)r;
+}
+
+#endif
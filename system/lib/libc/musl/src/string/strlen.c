@@ -1,3 +1,20 @@
+#ifdef __EMSCRIPTEN__
+/* XXX EMSCRIPTEN: 64-bit word at a time. */
+#include <string.h>
+#include "string_words.h"
+
+size_t strlen(const char *s)
+{
+	const char *a = s;
+	const sword *w;
+	sword m;
+	for (; (uintptr_t)s & SW_ALIGN; s++) if (!*s) return s-a;
+	for (w = (const void *)s; !(m = SW_HASZERO(*w)); w++);
+	return (const char *)w + SW_FIRST(m) - a;
+}
+
+#else
+
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
@@ -16,3 +33,5 @@ size_t strlen(const char *s)
 	for (s = (const void *)w; *s; s++);
 	return s-a;
 }
+
+#endif
@@ -6,6 +6,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <assert.h>
+#include <stdint.h>
 
 #include <emscripten.h>
 
@@ -27,8 +28,30 @@ void* mspace_memalign(mspace msp, size_t alignment, size_t bytes);
 static bool initialized = false;
 static size_t total_memory = 0;
 static size_t split_memory = 0;
+static size_t split_shift = 0; // log2(split_memory), which emcc ensures is a power of 2
 static size_t num_spaces = 0;
 
+// Allocations are segregated by size into classes, and each space only serves one class at a time, so that a
+// few large blocks do not end up scattered among, and pinning, spaces full of small ones.
+enum SizeClass {
+  NO_CLASS = -1,
+  SMALL = 0,
+  LARGE = 1,
+  NUM_CLASSES = 2
+};
+
+static SizeClass get_size_class(size_t size) {
+  return size >= (split_memory >> 3) ? LARGE : SMALL;
+}
+
+// An allocation failure in a space for a request at most this large means the space is effectively full, and it
+// is not tried again until something in it is freed.
+#define FULL_FAILURE_SIZE 256
+
+// How many empty spaces are kept around instead of releasing them, so that a single allocation repeatedly
+// freed and made again does not create and destroy a space (and its JS chunk) each time.
+#define MAX_EMPTY_SPACES 2
+
 enum AllocateResult {
   OK = 0,
   NO_MEMORY = 1,
@@ -40,18 +63,27 @@ struct Space {
   bool allocated; // whether storage is allocated for this chunk, both an ArrayBuffer in JS and an mspace here
   size_t count; // how many allocations are in the space
   size_t index; // the index of this space, it then represents memory at SPLIT_MEMORY*index
+  SizeClass size_class; // the class of allocations this space serves, or NO_CLASS while it is unused
+  size_t failed_size; // the smallest malloc that failed here since the last free, larger ones are not tried
+  size_t failed_aligned_size; // the same for memalign, by size plus alignment, as that is what it needs room for
+
+  void clear_failures() {
+    failed_size = split_memory;
+    failed_aligned_size = split_memory;
+  }
 
   void init(int i) {
     space = 0;
     allocated = false;
     count = 0;
     index = i;
+    size_class = NO_CLASS;
+    clear_failures();
   }
 
   AllocateResult allocate() {
     assert(!allocated);
     assert(count == 0);
-    allocated = true;
     int start;
     if (index > 0) {
       if (int(split_memory*(index+1)) < 0) {
@@ -83,37 +115,72 @@ struct Space {
       }
     }
     assert(space);
+    allocated = true;
+    clear_failures();
     return OK;
   }
 
   void free() {
     assert(allocated);
     assert(count == 0);
+    assert(index > 0); // the first chunk holds the runtime, and is never released
     allocated = false;
-    destroy_mspace((void*)(split_memory*index));
-    if (index > 0) {
-      EM_ASM({ freeSplitChunk($0) }, index);
-    }
+    size_class = NO_CLASS;
+    destroy_mspace(space);
+    space = 0;
+    EM_ASM({ freeSplitChunk($0) }, index);
   }
 };
 
 static Space spaces[MAX_SPACES];
 
+// A set of space indexes, so that a space with room can be found without probing every space in turn.
+struct SpaceSet {
+  uint32_t bits[(MAX_SPACES + 31) / 32];
+
+  void add(size_t i) { bits[i >> 5] |= 1u << (i & 31); }
+  void remove(size_t i) { bits[i >> 5] &= ~(1u << (i & 31)); }
+
+  // The lowest index in the set that is at least |from|, or -1. Lower spaces are preferred, which keeps
+  // allocations packed together and filling one space at a time.
+  int next(size_t from) const {
+    if (from >= num_spaces) return -1;
+    size_t word = from >> 5;
+    uint32_t curr = bits[word] & (~0u << (from & 31));
+    size_t words = (num_spaces + 31) >> 5;
+    while (1) {
+      if (curr) {
+        size_t i = (word << 5) + __builtin_ctz(curr);
+        return i < num_spaces ? int(i) : -1;
+      }
+      if (++word == words) return -1;
+      curr = bits[word];
+    }
+  }
+};
+
+static SpaceSet open_spaces[NUM_CLASSES]; // allocated spaces of each class that may have room
+static SpaceSet empty_spaces; // allocated spaces with no allocations and no class, kept for reuse
+static SpaceSet unallocated_spaces; // spaces that have no storage yet and may get it
+static size_t num_empty_spaces = 0;
+
 static void init() {
   total_memory = EM_ASM_INT({ return TOTAL_MEMORY; });
   split_memory = EM_ASM_INT({ return SPLIT_MEMORY; });
+  assert((split_memory & (split_memory - 1)) == 0);
+  split_shift = __builtin_ctz(split_memory);
   num_spaces = EM_ASM_INT({ return HEAPU8s.length; });
   if (num_spaces >= MAX_SPACES) abort();
   for (int i = 0; i < num_spaces; i++) {
     spaces[i].init(i);
+    unallocated_spaces.add(i);
   }
   initialized = true;
 }
 
-// TODO: optimize, these are powers of 2
 // TODO: add optional asserts in these
-#define space_index(ptr) (((unsigned)ptr) / split_memory)
-#define space_relative(ptr) (((unsigned)ptr) % split_memory)
+#define space_index(ptr) (((unsigned)ptr) >> split_shift)
+#define space_relative(ptr) (((unsigned)ptr) & (split_memory - 1))
 
 static mspace get_space(void* ptr) { // for a valid pointer, so the space must already exist
   int index = space_index(ptr);
@@ -123,7 +190,47 @@ static mspace get_space(void* ptr) { // for a valid pointer, so the space must a
   return space.space;
 }
 
-static void* get_memory(size_t size, bool malloc=true, size_t alignment=-1, bool must_succeed=false) {
+static void* try_space(Space& space, size_t size, bool malloc, size_t alignment) {
+  assert(space.allocated);
+  // a memalign needs at least as much room as a malloc of the same size, so failed mallocs rule out both
+  if (size >= space.failed_size) return 0;
+  size_t aligned_size = malloc ? 0 : size + alignment;
+  if (!malloc && aligned_size >= space.failed_aligned_size) return 0;
+  void *ret;
+  if (malloc) {
+    ret = mspace_malloc(space.space, size);
+  } else {
+    ret = mspace_memalign(space.space, alignment, size);
+  }
+  if (ret) {
+    space.count++;
+    return ret;
+  }
+  if (malloc) {
+    space.failed_size = size;
+  } else {
+    space.failed_aligned_size = aligned_size;
+  }
+  if ((malloc ? size : aligned_size) <= FULL_FAILURE_SIZE) {
+    open_spaces[space.size_class].remove(space.index);
+  }
+  return 0;
+}
+
+static void assign_class(Space& space, SizeClass size_class) {
+  space.size_class = size_class;
+  open_spaces[size_class].add(space.index);
+}
+
+static void* try_open_spaces(SizeClass size_class, size_t size, bool malloc, size_t alignment) {
+  for (int i = open_spaces[size_class].next(0); i >= 0; i = open_spaces[size_class].next(i + 1)) {
+    void* ret = try_space(spaces[i], size, malloc, alignment);
+    if (ret) return ret;
+  }
+  return 0;
+}
+
+static void* get_memory(size_t size, bool malloc=true, size_t alignment=-1) {
   if (!initialized) {
     init();
   }
@@ -137,37 +244,38 @@ static void* get_memory(size_t size, bool malloc=true, size_t alignment=-1, bool
     }
     return 0;
   }
-  static int next = 0;
-  int start = next;
-  while (1) { // simple round-robin, while keeping to use the same one as long as it keeps succeeding
-    AllocateResult result = OK;
-    if (!spaces[next].allocated) {
-      result = spaces[next].allocate();
-      if (result == NO_MEMORY) return 0; // mallocation failure
-    }
-    if (result == OK) {
-      void *ret;
-      if (malloc) {
-        ret = mspace_malloc(spaces[next].space, size);
-      } else {
-        ret = mspace_memalign(spaces[next].space, alignment, size);
-      }
-      if (ret) {
-        spaces[next].count++;
-        return ret;
-      }
-      if (must_succeed) {
-        EM_ASM({ Module.printErr("failed to allocate in a new space after memory growth, perhaps increase SPLIT_MEMORY?"); });
-        abort();
-      }
-    } else {
-      assert(result == ALREADY_USED); // continue on to the next space
-    }
-    next++;
-    if (next == num_spaces) next = 0;
-    if (next == start) break;
+  SizeClass size_class = get_size_class(size);
+  // spaces already serving this class
+  void* ret = try_open_spaces(size_class, size, malloc, alignment);
+  if (ret) return ret;
+  // a space that was emptied, before paying for a new chunk
+  for (int i = empty_spaces.next(0); i >= 0; i = empty_spaces.next(i + 1)) {
+    Space& space = spaces[i];
+    empty_spaces.remove(i);
+    num_empty_spaces--;
+    space.clear_failures();
+    assign_class(space, size_class);
+    ret = try_space(space, size, malloc, alignment);
+    if (ret) return ret;
+  }
+  // a new chunk
+  for (int i = unallocated_spaces.next(0); i >= 0; i = unallocated_spaces.next(i + 1)) {
+    Space& space = spaces[i];
+    AllocateResult result = space.allocate();
+    if (result == NO_MEMORY) return 0; // mallocation failure
+    unallocated_spaces.remove(i);
+    if (result == ALREADY_USED) continue; // other code owns it, never try it again
+    assign_class(space, size_class);
+    ret = try_space(space, size, malloc, alignment);
+    if (ret) return ret;
   }
-  // we cycled, so none of them can allocate
+  // every space is in use, so rather than fail, borrow room in spaces of another class
+  for (int c = 0; c < NUM_CLASSES; c++) {
+    if (c == size_class) continue;
+    ret = try_open_spaces(SizeClass(c), size, malloc, alignment);
+    if (ret) return ret;
+  }
+  // none of them can allocate
   int returnNull = EM_ASM_INT({
     if (!ABORTING_MALLOC && !ALLOW_MEMORY_GROWTH) return 1; // malloc can return 0, and we cannot grow
     if (!ALLOW_MEMORY_GROWTH) {
@@ -178,10 +286,37 @@ static void* get_memory(size_t size, bool malloc=true, size_t alignment=-1, bool
   if (returnNull) return 0;
   // memory growth is on, add another chunk
   if (num_spaces + 1 >= MAX_SPACES) abort();
-  spaces[num_spaces].init(num_spaces);
-  next = num_spaces;
+  Space& space = spaces[num_spaces];
+  space.init(num_spaces);
   num_spaces++;
-  return get_memory(size, malloc, alignment, true);
+  if (space.allocate() != OK) return 0;
+  assign_class(space, size_class);
+  ret = try_space(space, size, malloc, alignment);
+  if (!ret) {
+    EM_ASM({ Module.printErr("failed to allocate in a new space after memory growth, perhaps increase SPLIT_MEMORY?"); });
+    abort();
+  }
+  return ret;
+}
+
+// Called when the last allocation in a space is freed. Up to MAX_EMPTY_SPACES spaces are kept so they can be
+// reused by any class, and past that the space is released.
+static void space_emptied(Space& space) {
+  assert(space.count == 0);
+  if (space.index == 0) {
+    // the first chunk can never be released, so it stays in its class, and may have been dropped as full
+    open_spaces[space.size_class].add(space.index);
+    return;
+  }
+  open_spaces[space.size_class].remove(space.index);
+  if (num_empty_spaces < MAX_EMPTY_SPACES) {
+    space.size_class = NO_CLASS;
+    empty_spaces.add(space.index);
+    num_empty_spaces++;
+    return;
+  }
+  space.free();
+  unallocated_spaces.add(space.index);
 }
 
 extern "C" {
@@ -196,13 +331,15 @@ void* memalign(size_t alignment, size_t size) {
 
 void free(void* ptr) {
   if (ptr == 0) return;
-  int index = space_index(ptr);
-  Space& space = spaces[index];
+  Space& space = spaces[space_index(ptr)];
   assert(space.count > 0);
   mspace_free(get_space(ptr), ptr);
   space.count--;
+  space.clear_failures(); // the freed memory may satisfy requests that failed before
   if (space.count == 0) {
-    spaces[index].free();
+    space_emptied(space);
+  } else {
+    open_spaces[space.size_class].add(space.index);
   }
 }
 
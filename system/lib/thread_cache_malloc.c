@@ -0,0 +1,173 @@
+/*
+   malloc/calloc/free with per-thread caches, for -s USE_PTHREADS=1 -s MALLOC_THREAD_CACHE=1
+
+   dlmalloc serializes every call on a single mutex, which becomes the bottleneck once several threads allocate at
+   the same time. This keeps a small per-thread cache of free blocks for each small size class in front of it, so the
+   common malloc()/free() of a small block touches only thread-local state. Cache misses refill a size class with one
+   batched dlindependent_comalloc(), and full size classes are drained with one dlbulk_free(), so the dlmalloc lock is
+   taken once per batch rather than once per call.
+
+   Cached blocks are ordinary dlmalloc chunks, so a block may be freed by any thread, and it simply goes to the cache
+   of the thread that frees it. Everything besides malloc(), calloc() and free() is served by dlmalloc.c directly.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+void* dlmalloc(size_t);
+void* dlcalloc(size_t, size_t);
+void dlfree(void*);
+size_t dlmalloc_usable_size(void*);
+void** dlindependent_comalloc(size_t, size_t*, void**);
+size_t dlbulk_free(void**, size_t);
+
+#define WEAK __attribute__((__weak__, __visibility__("default")))
+
+#define SIZE_CLASS_SHIFT 3
+#define NUM_SIZE_CLASSES 32 // Size classes of 8, 16, ..., 256 bytes.
+#define MAX_CACHED_SIZE (NUM_SIZE_CLASSES << SIZE_CLASS_SHIFT)
+#define MAX_CACHED_BLOCKS 64 // Per size class, per thread.
+#define BATCH_SIZE 16 // Number of blocks moved between a thread cache and dlmalloc at a time.
+
+// Free blocks are kept in singly linked lists threaded through their first word. dlmalloc chunks always have room
+// for at least one pointer.
+typedef struct thread_cache
+{
+	void *free_blocks[NUM_SIZE_CLASSES];
+	unsigned num_free_blocks[NUM_SIZE_CLASSES];
+} thread_cache;
+
+// Stored in the key after a thread's cache has been torn down, so that frees made by later pthread key destructors
+// on that thread go straight to dlmalloc instead of recreating the cache.
+#define CACHE_DESTROYED ((thread_cache*)-1)
+
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+static volatile int cache_key_state = 0; // 0: not created yet, 1: created, -1: creation failed
+
+static void drain_size_class(thread_cache *cache, unsigned size_class, unsigned num_blocks)
+{
+	void *blocks[BATCH_SIZE];
+	while(num_blocks > 0)
+	{
+		unsigned n = num_blocks < BATCH_SIZE ? num_blocks : BATCH_SIZE;
+		for(unsigned i = 0; i < n; ++i)
+		{
+			blocks[i] = cache->free_blocks[size_class];
+			cache->free_blocks[size_class] = *(void**)blocks[i];
+		}
+		cache->num_free_blocks[size_class] -= n;
+		num_blocks -= n;
+		dlbulk_free(blocks, n);
+	}
+}
+
+static void destroy_thread_cache(void *arg)
+{
+	thread_cache *cache = (thread_cache*)arg;
+	if (cache == CACHE_DESTROYED) return; // Leave the key cleared, so that the destructor is not called again.
+	for(unsigned i = 0; i < NUM_SIZE_CLASSES; ++i)
+		drain_size_class(cache, i, cache->num_free_blocks[i]);
+	dlfree(cache);
+	// Destructors that run later on this thread may still free memory; keep them from creating a new cache.
+	pthread_setspecific(cache_key, CACHE_DESTROYED);
+}
+
+static void create_cache_key()
+{
+	cache_key_state = pthread_key_create(&cache_key, destroy_thread_cache) == 0 ? 1 : -1;
+}
+
+// Returns the calling thread's cache, or 0 if caching is not available, in which case dlmalloc should be used directly.
+static thread_cache *get_thread_cache()
+{
+	if (!pthread_self()) return 0; // The pthreads runtime is not yet initialized.
+	if (cache_key_state == 0) pthread_once(&cache_key_once, create_cache_key);
+	if (cache_key_state < 0) return 0;
+
+	thread_cache *cache = (thread_cache*)pthread_getspecific(cache_key);
+	if (cache == CACHE_DESTROYED) return 0;
+	if (!cache)
+	{
+		cache = (thread_cache*)dlcalloc(1, sizeof(thread_cache));
+		if (!cache) return 0;
+		pthread_setspecific(cache_key, cache);
+	}
+	return cache;
+}
+
+static void *refill_size_class(thread_cache *cache, unsigned size_class)
+{
+	size_t sizes[BATCH_SIZE];
+	void *blocks[BATCH_SIZE];
+	for(int i = 0; i < BATCH_SIZE; ++i)
+		sizes[i] = (size_class + 1) << SIZE_CLASS_SHIFT;
+	if (!dlindependent_comalloc(BATCH_SIZE, sizes, blocks)) return 0;
+
+	// Hand out blocks[0] to the caller and cache the rest.
+	for(int i = BATCH_SIZE-1; i > 0; --i)
+	{
+		*(void**)blocks[i] = cache->free_blocks[size_class];
+		cache->free_blocks[size_class] = blocks[i];
+	}
+	cache->num_free_blocks[size_class] += BATCH_SIZE-1;
+	return blocks[0];
+}
+
+WEAK void *malloc(size_t bytes)
+{
+	if (bytes <= MAX_CACHED_SIZE)
+	{
+		thread_cache *cache = get_thread_cache();
+		if (cache)
+		{
+			unsigned size_class = bytes ? (unsigned)(bytes - 1) >> SIZE_CLASS_SHIFT : 0;
+			void *mem = cache->free_blocks[size_class];
+			if (mem)
+			{
+				cache->free_blocks[size_class] = *(void**)mem;
+				--cache->num_free_blocks[size_class];
+				return mem;
+			}
+			mem = refill_size_class(cache, size_class);
+			if (mem) return mem;
+		}
+	}
+	return dlmalloc(bytes);
+}
+
+WEAK void *calloc(size_t num, size_t size)
+{
+	size_t bytes = num * size;
+	if (bytes <= MAX_CACHED_SIZE && (num | size) < 0x10000) // Cannot have overflowed.
+	{
+		void *mem = malloc(bytes);
+		if (mem) memset(mem, 0, bytes);
+		return mem;
+	}
+	return dlcalloc(num, size);
+}
+
+WEAK void free(void *mem)
+{
+	if (!mem) return;
+	size_t usable = dlmalloc_usable_size(mem);
+	// Cache the block in the largest size class it can serve. A request of (c+1)*8 bytes gets a usable size of
+	// (c+1)*8+4, so blocks handed out from class c return to class c.
+	if (usable >= (1 << SIZE_CLASS_SHIFT) && usable < ((NUM_SIZE_CLASSES + 1) << SIZE_CLASS_SHIFT))
+	{
+		thread_cache *cache = get_thread_cache();
+		if (cache)
+		{
+			unsigned size_class = (unsigned)(usable >> SIZE_CLASS_SHIFT) - 1;
+			if (cache->num_free_blocks[size_class] >= MAX_CACHED_BLOCKS)
+				drain_size_class(cache, size_class, MAX_CACHED_BLOCKS / 2);
+			*(void**)mem = cache->free_blocks[size_class];
+			cache->free_blocks[size_class] = mem;
+			++cache->num_free_blocks[size_class];
+			return;
+		}
+	}
+	dlfree(mem);
+}
@@ -0,0 +1,65 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten/emscripten.h>
+
+// Appends enough data to span several storage pages, then writes past the end of the file and checks
+// that the gap reads back as zeroes.
+void append_file()
+{
+  FILE *file = fopen("log.txt", "wb");
+  assert(file);
+  char line[100];
+  for(int i = 0; i < 1000; ++i)
+  {
+    sprintf(line, "line %04d\n", i);
+    size_t written = fwrite(line, 1, strlen(line), file);
+    assert(written == strlen(line));
+  }
+  fclose(file);
+
+  file = fopen("log.txt", "rb");
+  assert(file);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  printf("log.txt is %ld bytes\n", size);
+  assert(size == 1000 * 10);
+  fseek(file, 999 * 10, SEEK_SET);
+  size_t read = fread(line, 1, 10, file);
+  assert(read == 10);
+  assert(!memcmp(line, "line 0999\n", 10));
+  fclose(file);
+}
+
+void sparse_file()
+{
+  FILE *file = fopen("sparse.bin", "wb");
+  assert(file);
+  fwrite("head", 1, 4, file);
+  fseek(file, 100000, SEEK_SET);
+  fwrite("tail", 1, 4, file);
+  fclose(file);
+
+  file = fopen("sparse.bin", "rb");
+  assert(file);
+  char *data = (char*)malloc(100004);
+  size_t read = fread(data, 1, 100004, file);
+  printf("read %u bytes from sparse.bin\n", (unsigned int)read);
+  assert(read == 100004);
+  assert(!memcmp(data, "head", 4));
+  for(int i = 4; i < 100000; ++i) assert(data[i] == 0);
+  assert(!memcmp(data + 100000, "tail", 4));
+  free(data);
+  fclose(file);
+}
+
+int main()
+{
+  append_file();
+  sparse_file();
+
+#ifdef REPORT_RESULT
+  REPORT_RESULT(0);
+#endif
+}
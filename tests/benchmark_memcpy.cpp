@@ -21,23 +21,38 @@ char src[1024*1024*64+16] = {};
 
 uint8_t resultCheckSum = 0;
 
+// Misalign the source and/or the destination by this many bytes.
+#ifndef SRC_OFFSET
+#define SRC_OFFSET 0
+#endif
+#ifndef DST_OFFSET
+#define DST_OFFSET 0
+#endif
+
+#ifdef OVERLAP
+// memmove() within the source buffer, to OVERLAP bytes after the source (or before it, if negative; at least -64).
+#define COPY(copySize) memmove(src + 64 + SRC_OFFSET + OVERLAP, src + 64 + SRC_OFFSET, copySize); resultCheckSum += src[64 + SRC_OFFSET + OVERLAP + ((copySize) >> 1)]
+#else
+#define COPY(copySize) memcpy(dst + DST_OFFSET, src + SRC_OFFSET, copySize); resultCheckSum += dst[DST_OFFSET + ((copySize) >> 1)]
+#endif
+
 void __attribute__((noinline)) test_memcpy(int numTimes, int copySize)
 {
 	for(int i = 0; i < numTimes - 8; i += 8)
 	{
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
+		COPY(copySize);
+		COPY(copySize);
+		COPY(copySize);
+		COPY(copySize);
+		COPY(copySize);
+		COPY(copySize);
+		COPY(copySize);
+		COPY(copySize);
 	}
 	numTimes &= 15;
 	for(int i = 0; i < numTimes; ++i)
 	{
-		memcpy(dst, src, copySize); resultCheckSum += dst[copySize >> 1];
+		COPY(copySize);
 	}
 }
 
@@ -20,23 +20,28 @@ char dst[1024*1024*64+16] = {};
 
 uint8_t resultCheckSum = 0;
 
+// Misalign the destination by this many bytes.
+#ifndef DST_OFFSET
+#define DST_OFFSET 0
+#endif
+
 void __attribute__((noinline)) test_memset(int numTimes, int copySize)
 {
 	for(int i = 0; i < numTimes - 8; i += 8)
 	{
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
 	}
 	numTimes &= 15;
 	for(int i = 0; i < numTimes; ++i)
 	{
-		memset(dst, i ^ 0xAA, copySize); resultCheckSum += dst[copySize >> 1];
+		memset(dst + DST_OFFSET, i ^ 0xAA, copySize); resultCheckSum += dst[DST_OFFSET + (copySize >> 1)];
 	}
 }
 
@@ -0,0 +1,21 @@
+#include <stdio.h>
+#include <emscripten.h>
+
+// Measures stdout throughput of a printf-heavy program, e.g. a chatty server log.
+#ifndef NUM_LINES
+#define NUM_LINES 100000
+#endif
+
+int main() {
+  double t0 = emscripten_get_now();
+  for(int i = 0; i < NUM_LINES; ++i) {
+    printf("log line %d: the quick brown fox jumps over the lazy dog\n", i);
+  }
+  fflush(stdout);
+  double t1 = emscripten_get_now();
+  fprintf(stderr, "OK. Time: %f msecs for %d lines (%f lines/msec).\n", t1-t0, NUM_LINES, NUM_LINES / (t1-t0));
+
+#ifdef REPORT_RESULT
+  REPORT_RESULT(0);
+#endif
+}
@@ -57,6 +57,27 @@ int main() {
     free(str);
   }
   double t3 = emscripten_get_now();
+
+  // Long strings, where finding the terminator matters most, and a round trip through stringToUTF16.
+  double tLong = 0;
+  for(int i = 0; i < 100; ++i) {
+    unsigned short *str = randomString(4*1024);
+    int len = 0;
+    while(str[len]) ++len;
+    unsigned short *out = new unsigned short[len+1];
+    tLong += EM_ASM_DOUBLE({
+      var t0 = _emscripten_get_now();
+      var str = Module.UTF16ToString($0);
+      var t1 = _emscripten_get_now();
+      assert(Module.lengthBytesUTF16(str) === $2*2);
+      Module.stringToUTF16(str, $1, $2*2+2);
+      return (t1-t0);
+    }, str, out, len);
+    assert(!memcmp(str, out, (len+1)*2));
+    delete[] out;
+    delete[] str;
+  }
+  printf("Long strings: decode %f.\n", tLong);
   printf("OK. Time: %f (%f).\n", t, t3-t2);
 
 #ifdef REPORT_RESULT
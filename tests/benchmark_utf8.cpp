@@ -16,6 +16,21 @@ double test(const char *str) {
   return res;
 }
 
+// Encodes the string back into the heap, and checks that the bytes are the same.
+double testEncode(const char *str, char *out, int outSize) {
+  double res = EM_ASM_DOUBLE({
+    var str = Module.UTF8ToString($0);
+    var t0 = _emscripten_get_now();
+    var len = Module.lengthBytesUTF8(str);
+    Module.stringToUTF8(str, $1, $2);
+    var t1 = _emscripten_get_now();
+    assert(len === $2 - 1);
+    return (t1-t0);
+  }, str, out, outSize);
+  assert(!strcmp(str, out));
+  return res;
+}
+
 char *utf8_corpus = 0;
 long utf8_corpus_length = 0;
 
@@ -58,6 +73,19 @@ int main() {
     free(str);
   }
   double t3 = emscripten_get_now();
+
+  // Long strings, where finding the terminator and encoding straight into the heap matter most.
+  double tLong = 0, tEncode = 0;
+  for(int i = 0; i < 1000; ++i) {
+    char *str = randomString(4*1024);
+    tLong += test(str);
+    int size = strlen(str) + 1;
+    char *out = new char[size];
+    tEncode += testEncode(str, out, size);
+    delete[] out;
+    delete[] str;
+  }
+  printf("Long strings: decode %f, encode %f.\n", tLong, tEncode);
   printf("OK. Time: %f (%f).\n", t, t3-t2);
 
 #ifdef REPORT_RESULT
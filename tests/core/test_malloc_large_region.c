@@ -0,0 +1,33 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define LARGE (4*1024*1024)
+
+int main(int argc, char **argv)
+{
+  // A large transient buffer, freed while small allocations are made around it, keeps being reused instead of
+  // being split up by the small allocations.
+  char* first = 0;
+  char* small[100];
+  for (int i = 0; i < 100; i++) {
+    char* large = (char*)malloc(LARGE);
+    assert(large);
+    if (!first) first = large;
+    assert(large == first);
+    memset(large, 1 + i, LARGE);
+    small[i] = (char*)malloc(64);
+    memset(small[i], i, 64);
+    free(large);
+  }
+  for (int i = 0; i < 100; i++) {
+    assert(small[i][0] == i && small[i][63] == i);
+  }
+  // reused large chunks are not assumed to be cleared
+  char* zeroed = (char*)calloc(1, LARGE);
+  assert(zeroed[0] == 0 && zeroed[LARGE / 2] == 0 && zeroed[LARGE - 1] == 0);
+  free(zeroed);
+  printf("ok.\n");
+  return 0;
+}
@@ -0,0 +1,27 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "emscripten.h"
+
+int get_TOTAL_MEMORY() {
+  return EM_ASM_INT({ return TOTAL_MEMORY });
+}
+
+int main(int argc, char **argv)
+{
+  int before = get_TOTAL_MEMORY();
+  assert(emscripten_heap_reserve(0));
+  int reserved = 3 * before;
+  assert(emscripten_heap_reserve(reserved));
+  int after = get_TOTAL_MEMORY();
+  assert(after > before + reserved / 2);
+  // allocating out of the reserved memory needs no further growth
+  for (int i = 0; i < 10; i++) {
+    assert(malloc(reserved / 20));
+  }
+  assert(get_TOTAL_MEMORY() == after);
+  // more than can ever be had
+  assert(!emscripten_heap_reserve(0x7fffffff));
+  printf("ok.\n");
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// Checks the word-at-a-time string functions against simple byte loops, for every alignment of the operands
+// and every length around a few word sizes.
+
+static int sign(int x) { return (x > 0) - (x < 0); }
+
+static int ref_memcmp(const char *l, const char *r, size_t n) {
+  for (; n && *l == *r; n--, l++, r++);
+  return n ? (unsigned char)*l - (unsigned char)*r : 0;
+}
+
+static int ref_strcmp(const char *l, const char *r) {
+  for (; *l == *r && *l; l++, r++);
+  return (unsigned char)*l - (unsigned char)*r;
+}
+
+int main() {
+  static char a[128], b[128];
+  int checks = 0;
+  for (int oa = 0; oa < 8; oa++) {
+    for (int ob = 0; ob < 8; ob++) {
+      for (int n = 0; n < 40; n++) {
+        for (int diff = -1; diff < n; diff++) {
+          memset(a, 0x55, sizeof(a));
+          memset(b, 0x55, sizeof(b));
+          for (int i = 0; i < n; i++) a[oa + i] = b[ob + i] = (char)(0x80 + i);
+          a[oa + n] = b[ob + n] = 0;
+          if (diff >= 0) b[ob + diff] = (char)(diff & 1 ? 0x01 : 0xff);
+          const char *l = a + oa, *r = b + ob;
+          assert(strlen(l) == n);
+          assert(sign(strcmp(l, r)) == sign(ref_strcmp(l, r)));
+          assert(sign(memcmp(l, r, n)) == sign(ref_memcmp(l, r, n)));
+          if (diff >= 0) {
+            char c = r[diff];
+            assert(memchr(r, c, n) == r + diff);
+            assert(memchr(r, c, diff) == NULL);
+            if (c) assert(strchr(r, c) == r + diff);
+          }
+          assert(strchr(l, 0) == l + n);
+          assert(strchr(l, 0x7f) == NULL);
+          checks++;
+        }
+      }
+    }
+  }
+  printf("%d checks passed\n", checks);
+  return 0;
+}
@@ -475,6 +475,30 @@ module({
             assert.equal(1, object.baz);
         });
 
+        test("property chains on temporary vals release their handles", function() {
+            var c = {};
+            assert.equal(c, cm.emval_test_get_nested_property({a: {b: {c: c}}}));
+            assert.equal(undefined, cm.emval_test_get_nested_property({a: {b: {}}}));
+            assert.equal(0, cm.count_emval_handles());
+
+            if (cm.emval_handle_stats) {
+                var stats = cm.emval_handle_stats();
+                assert.equal(0, stats.live);
+                assert.equal(stats.registered, stats.freed);
+            }
+        });
+
+        test("val_batch runs recorded operations", function() {
+            var object = {items: [{x: 1}, 'b']};
+            var rv = cm.emval_test_run_batch(object);
+            assert.equal(object.items[0], object.first);
+            assert.deepEqual([{x: 1}, 'b', 'label', 2.5], object.items);
+            assert.equal('\u00fcber', object['\u00e9t\u00e9']);
+            assert.equal(4, rv.length);
+            assert.equal(object.items, rv.items);
+            assert.equal(0, cm.count_emval_handles());
+        });
+
         test("pass const reference to primitive", function() {
             assert.equal(3, cm.const_ref_adder(1, 2));
         });
@@ -609,6 +633,18 @@ module({
             assert.equal("foo\0bar", cm.emval_test_take_and_return_std_string("foo\0bar"));
         });
 
+        test("std::string_view", function() {
+            assert.equal("foobar", cm.emval_test_take_and_return_std_string_view("foobar"));
+            assert.equal("", cm.emval_test_take_and_return_std_string_view(""));
+        });
+
+        test("strings larger than the string arena", function() {
+            var long = new Array(40001).join('x');
+            assert.equal(long, cm.emval_test_take_and_return_std_string(long));
+            assert.equal("a" + long + "c", cm.emval_test_concatenate_std_strings("a", long, "c"));
+            assert.equal("abc", cm.emval_test_concatenate_std_strings("a", "b", "c"));
+        });
+
         test("no memory leak when passing strings in by const reference", function() {
             cm.emval_test_take_and_return_std_string_const_ref("foobar");
         });
@@ -1014,6 +1050,56 @@ module({
             assert.equal(20, vec.get(1));
             vec.delete();
         });
+
+        test("numeric vectors can be copied to a typed array", function() {
+            var vec = cm.emval_test_return_vector();
+            var array = vec.toTypedArray();
+            assert.true(array instanceof Int32Array);
+            assert.deepEqual([10, 20, 30], Array.prototype.slice.call(array));
+
+            // The copy does not alias the vector.
+            vec.set(0, 40);
+            assert.equal(10, array[0]);
+            vec.delete();
+        });
+
+        test("numeric vectors can be viewed as a typed array", function() {
+            var vec = cm.emval_test_return_vector();
+            var view = vec.typedArrayView();
+            assert.equal(3, view.length);
+            view[1] = 50;
+            assert.equal(50, vec.get(1));
+            vec.delete();
+        });
+
+        test("numeric vectors can be assigned from a typed array", function() {
+            var vec = new cm.FloatVector();
+            vec.reserve(4);
+            vec.assignFromTypedArray(new Float32Array([1.5, 2.5, 3.5, 4.5]));
+            assert.equal(4, vec.size());
+            assert.equal(1.5, vec.get(0));
+            assert.equal(4.5, vec.get(3));
+
+            vec.assignFromTypedArray([7, 8]);
+            assert.equal(2, vec.size());
+            assert.equal(8, vec.get(1));
+            vec.delete();
+        });
+
+        test("numeric vectors support range get and set", function() {
+            var vec = new cm.FloatVector();
+            vec.assignFromTypedArray(new Float32Array([0, 1, 2, 3, 4]));
+
+            assert.deepEqual([1, 2, 3], Array.prototype.slice.call(vec.getRange(1, 4)));
+            assert.deepEqual([3, 4], Array.prototype.slice.call(vec.getRange(3, 10)));
+            assert.equal(0, vec.getRange(4, 2).length);
+
+            assert.true(vec.setRange(2, new Float32Array([20, 30])));
+            assert.deepEqual([0, 1, 20, 30, 4], Array.prototype.slice.call(vec.toTypedArray()));
+            assert.false(vec.setRange(4, new Float32Array([40, 50])));
+            assert.equal(4, vec.get(4));
+            vec.delete();
+        });
     });
 
     BaseFixture.extend("map", function() {
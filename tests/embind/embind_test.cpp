@@ -39,6 +39,27 @@ val emval_test_new_object() {
     return rv;
 }
 
+val emval_test_get_nested_property(val object) {
+    return object["a"]["b"]["c"];
+}
+
+val emval_test_run_batch(val object) {
+    val_batch batch;
+    auto obj = batch.input(object);
+    auto items = batch.get(obj, "items");
+    batch.set(obj, "first", batch.get(items, 0u));
+    auto length = batch.call(items, "push", {batch.string("label"), batch.number(2.5)});
+    batch.set(obj, "\xc3\xa9t\xc3\xa9", batch.string("\xc3\xbc" "ber")); // UTF-8 "été" and "über"
+    size_t lengthIndex = batch.read_number(length);
+    size_t itemsIndex = batch.keep(items);
+    batch.run();
+
+    val rv(val::object());
+    rv.set("length", val(batch.number_result(lengthIndex)));
+    rv.set("items", batch.take(itemsIndex));
+    return rv;
+}
+
 struct DummyForPointer {
     int value;
     DummyForPointer(const int v) : value(v) {}
@@ -159,6 +180,14 @@ std::string emval_test_take_and_return_std_string_const_ref(const std::string& s
     return str;
 }
 
+std::string_view emval_test_take_and_return_std_string_view(std::string_view str) {
+    return str;
+}
+
+std::string emval_test_concatenate_std_strings(std::string a, std::string b, std::string c) {
+    return a + b + c;
+}
+
 std::basic_string<unsigned char> emval_test_take_and_return_std_basic_string_unsigned_char(std::basic_string<unsigned char> str) {
     return str;
 }
@@ -1677,6 +1706,8 @@ EMSCRIPTEN_BINDINGS(tests) {
     function("emval_test_new_string", &emval_test_new_string);
     function("emval_test_get_string_from_val", &emval_test_get_string_from_val);
     function("emval_test_new_object", &emval_test_new_object);
+    function("emval_test_run_batch", &emval_test_run_batch);
+    function("emval_test_get_nested_property", &emval_test_get_nested_property);
     function("emval_test_instance_pointer", &emval_test_instance_pointer);
     function("emval_test_value_from_instance_pointer", &emval_test_value_from_instance_pointer);
     function("emval_test_passthrough_unsigned", &emval_test_passthrough_unsigned);
@@ -1705,6 +1736,8 @@ EMSCRIPTEN_BINDINGS(tests) {
     //function("emval_test_take_and_return_const_char_star", &emval_test_take_and_return_const_char_star);
     function("emval_test_take_and_return_std_string", &emval_test_take_and_return_std_string);
     function("emval_test_take_and_return_std_string_const_ref", &emval_test_take_and_return_std_string_const_ref);
+    function("emval_test_take_and_return_std_string_view", &emval_test_take_and_return_std_string_view);
+    function("emval_test_concatenate_std_strings", &emval_test_concatenate_std_strings);
     function("emval_test_take_and_return_std_basic_string_unsigned_char", &emval_test_take_and_return_std_basic_string_unsigned_char);
     function("take_and_return_std_wstring", &take_and_return_std_wstring);
 
@@ -0,0 +1,56 @@
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+#include <pthread.h>
+#include <emscripten/fetch.h>
+
+// Issues many concurrent waitable fetches from several threads, with a limit on the number of fetches
+// in flight, to exercise the multi-producer proxy queue to the fetch worker.
+#define NUM_THREADS 4
+#define FETCHES_PER_THREAD 100
+
+static void *fetch_thread(void *arg)
+{
+  int threadIndex = (int)(long)arg;
+  emscripten_fetch_t *fetches[FETCHES_PER_THREAD];
+  for(int i = 0; i < FETCHES_PER_THREAD; ++i)
+  {
+    emscripten_fetch_attr_t attr;
+    emscripten_fetch_attr_init(&attr);
+    strcpy(attr.requestMethod, "GET");
+    attr.attributes = EMSCRIPTEN_FETCH_REPLACE | EMSCRIPTEN_FETCH_LOAD_TO_MEMORY | EMSCRIPTEN_FETCH_WAITABLE;
+    if (threadIndex == 0) attr.attributes |= EMSCRIPTEN_FETCH_PRIORITY_HIGH;
+    if (threadIndex == NUM_THREADS-1) attr.attributes |= EMSCRIPTEN_FETCH_PRIORITY_LOW;
+    fetches[i] = emscripten_fetch(&attr, "gears.png");
+    assert(fetches[i]);
+  }
+  for(int i = 0; i < FETCHES_PER_THREAD; ++i)
+  {
+    EMSCRIPTEN_RESULT ret = emscripten_fetch_wait(fetches[i], INFINITY);
+    assert(ret == EMSCRIPTEN_RESULT_SUCCESS);
+    assert(fetches[i]->status == 200);
+    uint8_t checksum = 0;
+    for(int j = 0; j < fetches[i]->numBytes; ++j)
+      checksum ^= fetches[i]->data[j];
+    assert(checksum == 0x08);
+    emscripten_fetch_close(fetches[i]);
+  }
+  return 0;
+}
+
+int main()
+{
+  emscripten_fetch_set_max_in_flight(8);
+
+  pthread_t threads[NUM_THREADS];
+  for(int i = 0; i < NUM_THREADS; ++i)
+    pthread_create(&threads[i], 0, fetch_thread, (void*)(long)i);
+  for(int i = 0; i < NUM_THREADS; ++i)
+    pthread_join(threads[i], 0);
+
+  printf("All %d fetches finished.\n", NUM_THREADS * FETCHES_PER_THREAD);
+#ifdef REPORT_RESULT
+  REPORT_RESULT(0);
+#endif
+}
@@ -0,0 +1,58 @@
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+#include <emscripten/fetch.h>
+
+// Downloads a file into a small ring of caller-provided buffers, and checks that the data arrives intact
+// and in order through the onbufferfilled() handler, without the fetch allocating data of its own.
+#define BUFFER_SIZE 1000
+#define NUM_BUFFERS 3
+
+static char buffers[NUM_BUFFERS][BUFFER_SIZE];
+static int numBuffersFilled = 0;
+static uint64_t bytesReceived = 0;
+static uint8_t checksum = 0;
+
+int main()
+{
+  emscripten_fetch_attr_t attr;
+  emscripten_fetch_attr_init(&attr);
+  strcpy(attr.requestMethod, "GET");
+  attr.attributes = EMSCRIPTEN_FETCH_REPLACE | EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
+  attr.destinationBuffer = &buffers[0][0];
+  attr.destinationBufferSize = BUFFER_SIZE;
+  attr.numDestinationBuffers = NUM_BUFFERS;
+
+  attr.onbufferfilled = [](emscripten_fetch_t *fetch) {
+    assert(fetch->data == buffers[numBuffersFilled % NUM_BUFFERS]);
+    assert(fetch->dataOffset == bytesReceived);
+    assert(fetch->numBytes > 0 && fetch->numBytes <= BUFFER_SIZE);
+    for(int i = 0; i < fetch->numBytes; ++i)
+      checksum ^= fetch->data[i];
+    bytesReceived += fetch->numBytes;
+    ++numBuffersFilled;
+  };
+
+  attr.onsuccess = [](emscripten_fetch_t *fetch) {
+    printf("Finished downloading %llu bytes in %d buffers\n", bytesReceived, numBuffersFilled);
+    printf("Data checksum: %02X\n", checksum);
+    assert(fetch->data == 0);
+    assert(bytesReceived == fetch->totalBytes);
+    assert(numBuffersFilled == (int)((bytesReceived + BUFFER_SIZE - 1) / BUFFER_SIZE));
+    assert(checksum == 0x08);
+    emscripten_fetch_close(fetch);
+
+#ifdef REPORT_RESULT
+    REPORT_RESULT(1);
+#endif
+  };
+
+  attr.onerror = [](emscripten_fetch_t *fetch) {
+    printf("Download failed!\n");
+    assert(false && "Shouldn't fail!");
+  };
+
+  emscripten_fetch_t *fetch = emscripten_fetch(&attr, "gears.png");
+  assert(fetch != 0);
+}
@@ -0,0 +1,92 @@
+// A minimal in-memory IndexedDB, just enough for IDBFS, for testing it in node. Counts the requests made to it.
+var indexedDB = (function() {
+  var databases = {};
+  var stats = { transactions: 0, puts: 0, gets: 0, deletes: 0, cursors: 0 };
+
+  function later(func) {
+    setTimeout(func, 0);
+  }
+  function request(run) {
+    var req = {};
+    later(function() {
+      req.result = run();
+      if (req.onsuccess) req.onsuccess({ target: req });
+    });
+    return req;
+  }
+
+  function Store(data) {
+    this.data = data;
+    this.indexNames = { contains: function(name) { return name === 'timestamp'; } };
+  }
+  Store.prototype.createIndex = function() {};
+  Store.prototype.put = function(value, key) {
+    var data = this.data;
+    stats.puts++;
+    return request(function() { data[key] = value; });
+  };
+  Store.prototype.get = function(key) {
+    var data = this.data;
+    stats.gets++;
+    return request(function() { return data[key]; });
+  };
+  Store.prototype.delete = function(key) {
+    var data = this.data;
+    stats.deletes++;
+    return request(function() { delete data[key]; });
+  };
+  Store.prototype.index = function(name) {
+    var data = this.data;
+    return {
+      openKeyCursor: function() {
+        var keys = Object.keys(data).sort();
+        var i = 0;
+        var req = {};
+        stats.cursors++;
+        function step() {
+          later(function() {
+            var cursor = null;
+            if (i < keys.length) {
+              cursor = { primaryKey: keys[i], key: data[keys[i]][name], continue: function() { i++; step(); } };
+            }
+            req.onsuccess({ target: { result: cursor } });
+          });
+        }
+        step();
+        return req;
+      }
+    };
+  };
+
+  function DB(stores) {
+    this.stores = stores;
+    this.objectStoreNames = { contains: function(name) { return name in stores; } };
+  }
+  DB.prototype.createObjectStore = function(name) {
+    this.stores[name] = {};
+    return new Store(this.stores[name]);
+  };
+  DB.prototype.transaction = function(names, mode) {
+    var stores = this.stores;
+    stats.transactions++;
+    return { objectStore: function(name) { return new Store(stores[name]); } };
+  };
+
+  return {
+    stats: stats,
+    open: function(name, version) {
+      var req = {};
+      later(function() {
+        var created = !databases[name];
+        if (created) databases[name] = {};
+        var db = new DB(databases[name]);
+        if (created) {
+          req.onupgradeneeded({ target: { result: db, transaction: { objectStore: function(name) { return new Store(db.stores[name]); } } } });
+        }
+        req.result = db;
+        req.onsuccess();
+      });
+      return req;
+    }
+  };
+})();
@@ -0,0 +1,125 @@
+#include <aio.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <emscripten.h>
+
+#define CHUNK 4096
+#define CHUNKS 64
+
+static unsigned char data[CHUNK * CHUNKS];
+static unsigned char chunks[CHUNKS][CHUNK];
+static struct aiocb reads[CHUNKS];
+static struct aiocb *list[CHUNKS];
+static struct aiocb write_cb, fsync_cb;
+static int fd;
+
+static void fsynced(union sigval value) {
+  assert(aio_error(&fsync_cb) == 0);
+  assert(aio_return(&fsync_cb) == 0);
+  puts("fsync completed");
+  close(fd);
+  puts("success");
+}
+
+static void written(union sigval value) {
+  assert(value.sival_ptr == &write_cb);
+  assert(aio_error(&write_cb) == 0);
+  assert(aio_return(&write_cb) == 5);
+  puts("write completed");
+
+  // aio_fsync persists the mount, which for IDBFS happens asynchronously
+  memset(&fsync_cb, 0, sizeof(fsync_cb));
+  fsync_cb.aio_fildes = fd;
+  fsync_cb.aio_sigevent.sigev_notify = SIGEV_THREAD;
+  fsync_cb.aio_sigevent.sigev_notify_function = fsynced;
+  assert(aio_fsync(O_SYNC, &fsync_cb) == 0);
+  assert(aio_error(&fsync_cb) == EINPROGRESS);
+}
+
+static void all_read(union sigval value) {
+  assert(value.sival_int == CHUNKS);
+  for (int i = 0; i < CHUNKS; i++) {
+    assert(aio_error(&reads[i]) == 0);
+    assert(aio_return(&reads[i]) == CHUNK);
+    assert(memcmp(chunks[i], data + i * CHUNK, CHUNK) == 0);
+  }
+  puts("reads completed");
+
+  // waiting on a request carries it out right away
+  struct aiocb a, b;
+  char bufa[10], bufb[10];
+  memset(&a, 0, sizeof(a));
+  a.aio_fildes = fd;
+  a.aio_buf = bufa;
+  a.aio_nbytes = sizeof(bufa);
+  a.aio_offset = 100;
+  b = a;
+  b.aio_buf = bufb;
+  assert(aio_read(&a) == 0);
+  assert(aio_read(&b) == 0);
+  assert(aio_error(&a) == EINPROGRESS);
+  const struct aiocb *wait[] = { &a };
+  assert(aio_suspend(wait, 1, NULL) == 0);
+  assert(aio_return(&a) == sizeof(bufa));
+  assert(memcmp(bufa, data + 100, sizeof(bufa)) == 0);
+
+  // requests that have not started can be canceled
+  assert(aio_cancel(fd, &b) == AIO_CANCELED);
+  assert(aio_error(&b) == ECANCELED);
+  assert(aio_cancel(fd, &a) == AIO_ALLDONE);
+  puts("suspend and cancel work");
+
+  // bad descriptors fail up front
+  struct aiocb bad = a;
+  bad.aio_fildes = 1000;
+  assert(aio_read(&bad) == -1 && errno == EBADF);
+
+  memset(&write_cb, 0, sizeof(write_cb));
+  write_cb.aio_fildes = fd;
+  write_cb.aio_buf = (void *)"hello";
+  write_cb.aio_nbytes = 5;
+  write_cb.aio_offset = 10;
+  write_cb.aio_sigevent.sigev_notify = SIGEV_THREAD;
+  write_cb.aio_sigevent.sigev_notify_function = written;
+  write_cb.aio_sigevent.sigev_value.sival_ptr = &write_cb;
+  assert(aio_write(&write_cb) == 0);
+}
+
+int main() {
+  EM_ASM(
+    FS.mkdir('/db');
+    FS.mount(IDBFS, {}, '/db');
+  );
+
+  for (int i = 0; i < sizeof(data); i++) data[i] = i * 7;
+  fd = open("/db/file", O_RDWR | O_CREAT, 0644);
+  assert(fd >= 0);
+  assert(write(fd, data, sizeof(data)) == sizeof(data));
+
+  // queue every read at once, and hear back when they are all done
+  for (int i = 0; i < CHUNKS; i++) {
+    reads[i].aio_fildes = fd;
+    reads[i].aio_lio_opcode = LIO_READ;
+    reads[i].aio_buf = chunks[i];
+    reads[i].aio_nbytes = CHUNK;
+    reads[i].aio_offset = i * CHUNK;
+    list[i] = &reads[i];
+  }
+  struct sigevent done;
+  memset(&done, 0, sizeof(done));
+  done.sigev_notify = SIGEV_THREAD;
+  done.sigev_notify_function = all_read;
+  done.sigev_value.sival_int = CHUNKS;
+  assert(lio_listio(LIO_NOWAIT, list, CHUNKS, &done) == 0);
+
+  // nothing has run yet; that happens once main returns to the event loop
+  for (int i = 0; i < CHUNKS; i++) {
+    assert(aio_error(&reads[i]) == EINPROGRESS);
+  }
+  puts("reads queued");
+  return 0;
+}
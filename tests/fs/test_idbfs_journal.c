@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <emscripten.h>
+
+int main() {
+  EM_ASM(
+    var stats = indexedDB.stats;
+    var before;
+    function count(what) {
+      return stats[what] - before[what];
+    }
+    function snapshot() {
+      before = JSON.parse(JSON.stringify(stats));
+    }
+    function exists(path) {
+      return FS.analyzePath(path).exists;
+    }
+
+    FS.mkdir('/db');
+    FS.mount(IDBFS, {}, '/db');
+    FS.writeFile('/db/a', 'a1');
+    FS.mkdir('/db/dir');
+    FS.writeFile('/db/dir/b', 'b1');
+    FS.mkdir('/db/many');
+    for (var i = 0; i < 50; i++) {
+      FS.writeFile('/db/many/f' + i, 'f' + i);
+    }
+
+    // the first sync has no baseline, so it reconciles everything
+    snapshot();
+    FS.syncfs(false, function(err) {
+      assert(!err);
+      assert(count('cursors') === 1 && count('puts') === 54);
+
+      FS.writeFile('/db/a', 'a2');
+      FS.unlink('/db/many/f0');
+      FS.rename('/db/dir', '/db/dir2');
+
+      // later ones store just what changed, in one transaction, without reading the database
+      snapshot();
+      FS.syncfs(false, function(err) {
+        assert(!err);
+        Module.print('transactions: ' + count('transactions') + ', cursors: ' + count('cursors') + ', puts: ' + count('puts') + ', deletes: ' + count('deletes'));
+        assert(count('transactions') === 1 && count('cursors') === 0);
+        assert(count('puts') === 4); // a, dir2, dir2/b, and many, whose entries changed
+        assert(count('deletes') === 3); // many/f0, dir, dir/b
+
+        // nothing changed, nothing to do
+        snapshot();
+        FS.syncfs(false, function(err) {
+          assert(!err);
+          assert(count('transactions') === 0);
+
+          // a fresh mount of the same database sees the changes
+          FS.unmount('/db');
+          FS.mount(IDBFS, {}, '/db');
+          FS.syncfs(true, function(err) {
+            assert(!err);
+            assert(FS.readFile('/db/a', { encoding: 'utf8' }) === 'a2');
+            assert(FS.readFile('/db/dir2/b', { encoding: 'utf8' }) === 'b1');
+            assert(!exists('/db/dir'));
+            assert(!exists('/db/many/f0'));
+            assert(FS.readFile('/db/many/f1', { encoding: 'utf8' }) === 'f1');
+
+            // what a populate writes is not journaled again
+            snapshot();
+            FS.writeFile('/db/c', 'c1');
+            FS.syncfs(false, function(err) {
+              assert(!err);
+              assert(count('cursors') === 0 && count('puts') === 1 && count('deletes') === 0);
+              Module.print('success');
+            });
+          });
+        });
+      });
+    });
+  );
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <emscripten.h>
+
+// built with -s LZ4_CACHE_SIZE=16384, so 8 chunks of 2K are cached
+#define FILE_SIZE (64*1024)
+#define CHUNK_SIZE 2048
+
+char expected(int fd, int pos) {
+  return fd == 0 ? '0' + pos % 10 : 'a' + (pos / 10) % 26;
+}
+
+char buffer[FILE_SIZE];
+
+void check_read(int *fds, int which, int pos, int size) {
+  assert(lseek(fds[which], pos, SEEK_SET) == pos);
+  assert(read(fds[which], buffer, size) == size);
+  for (int i = 0; i < size; i++) {
+    assert(buffer[i] == expected(which, pos + i));
+  }
+}
+
+int decompressed() {
+  return EM_ASM_INT_V({ return Module['decompressedChunks']; });
+}
+
+int main() {
+  EM_ASM_({
+    var size = $0;
+    var data = new Uint8Array(size * 2);
+    for (var i = 0; i < size; i++) {
+      data[i] = 48 + i % 10;
+      data[size + i] = 97 + Math.floor(i / 10) % 26;
+    }
+    LZ4.loadPackage({ 'metadata': { 'files': [{ 'filename': '/a', 'start': 0, 'end': size },
+                                              { 'filename': '/b', 'start': size, 'end': 2*size }] },
+                      'data': data.buffer });
+    Module['decompressedChunks'] = 0;
+    var decompressChunk = LZ4.decompressChunk;
+    LZ4.decompressChunk = function() {
+      Module['decompressedChunks']++;
+      return decompressChunk.apply(LZ4, arguments);
+    };
+  }, FILE_SIZE);
+
+  int fds[2];
+  fds[0] = open("/a", O_RDONLY);
+  fds[1] = open("/b", O_RDONLY);
+  assert(fds[0] >= 0 && fds[1] >= 0);
+
+  // random reads only decompress the chunks they touch, and those stay cached
+  for (int i = 0; i < 8; i++) {
+    check_read(fds, 0, i*4*CHUNK_SIZE + 100, 16);
+  }
+  for (int i = 0; i < 8; i++) {
+    check_read(fds, 0, i*4*CHUNK_SIZE + 200, 16);
+  }
+  printf("random: %d\n", decompressed());
+  assert(decompressed() == 8);
+
+  // streaming through another file decompresses each of its chunks once, and keeps to one cache slot, besides the
+  // first chunk, which was read before the stream looked sequential
+  assert(lseek(fds[1], 0, SEEK_SET) == 0);
+  for (int pos = 0; pos < FILE_SIZE; pos += 100) {
+    int size = pos + 100 < FILE_SIZE ? 100 : FILE_SIZE - pos;
+    assert(read(fds[1], buffer, size) == size);
+    for (int i = 0; i < size; i++) {
+      assert(buffer[i] == expected(1, pos + i));
+    }
+  }
+  printf("stream: %d\n", decompressed());
+  assert(decompressed() == 8 + 32);
+  for (int i = 7; i >= 0; i--) {
+    check_read(fds, 0, i*4*CHUNK_SIZE + 300, 16);
+  }
+  printf("random again: %d\n", decompressed());
+  assert(decompressed() == 8 + 32 + 2);
+
+  // whole chunks in a large read are decompressed right into it, and not cached
+  check_read(fds, 0, 1000, 3*CHUNK_SIZE);
+  assert(decompressed() == 8 + 32 + 2 + 3);
+  check_read(fds, 0, CHUNK_SIZE + 10, 16);
+  assert(decompressed() == 8 + 32 + 2 + 3 + 1);
+
+  close(fds[0]);
+  close(fds[1]);
+  printf("success\n");
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FILE_SIZE (1024*1024 + 123)
+
+static unsigned char expected(int i) {
+  return (unsigned char)(i * 7 + (i >> 10));
+}
+
+int main() {
+  unsigned char buf[1000];
+  struct stat st;
+
+  // append in pieces that do not line up with the chunks
+  int fd = open("/big", O_CREAT | O_WRONLY, 0666);
+  assert(fd >= 0);
+  for (int pos = 0; pos < FILE_SIZE; pos += sizeof(buf)) {
+    int n = FILE_SIZE - pos < sizeof(buf) ? FILE_SIZE - pos : sizeof(buf);
+    for (int i = 0; i < n; i++) buf[i] = expected(pos + i);
+    assert(write(fd, buf, n) == n);
+  }
+  close(fd);
+  assert(stat("/big", &st) == 0 && st.st_size == FILE_SIZE);
+
+  // read it back across chunk boundaries
+  fd = open("/big", O_RDWR);
+  assert(fd >= 0);
+  for (int pos = 0; pos < FILE_SIZE; pos += 4093) {
+    int n = pread(fd, buf, sizeof(buf), pos);
+    assert(n == (FILE_SIZE - pos < sizeof(buf) ? FILE_SIZE - pos : sizeof(buf)));
+    for (int i = 0; i < n; i++) assert(buf[i] == expected(pos + i));
+  }
+
+  // overwrite in the middle
+  memset(buf, 0xAB, sizeof(buf));
+  assert(pwrite(fd, buf, sizeof(buf), 4096 - 10) == sizeof(buf));
+  assert(pread(fd, buf, sizeof(buf), 4096 - 20) == sizeof(buf));
+  for (int i = 0; i < 10; i++) assert(buf[i] == expected(4096 - 20 + i));
+  for (int i = 10; i < sizeof(buf); i++) assert(buf[i] == 0xAB);
+
+  // shrink and regrow: the regrown part reads as zeros
+  assert(ftruncate(fd, 10000) == 0);
+  assert(ftruncate(fd, 20000) == 0);
+  assert(pread(fd, buf, sizeof(buf), 9500) == sizeof(buf));
+  for (int i = 0; i < 500; i++) assert(buf[i] == expected(9500 + i));
+  for (int i = 500; i < sizeof(buf); i++) assert(buf[i] == 0);
+
+  // map a range that straddles chunks
+  unsigned char *map = mmap(NULL, 6000, PROT_READ, MAP_PRIVATE, fd, 4096);
+  assert(map != MAP_FAILED);
+  for (int i = 0; i < 6000; i++) {
+    int pos = 4096 + i;
+    assert(map[i] == (pos < 4096 - 10 + 1000 ? 0xAB : pos < 10000 ? expected(pos) : 0));
+  }
+  munmap(map, 6000);
+  close(fd);
+
+  puts("success");
+  return 0;
+}
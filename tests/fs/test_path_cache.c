@@ -0,0 +1,78 @@
+#include <assert.h>
+#include <stdio.h>
+#include <emscripten.h>
+
+int main() {
+  EM_ASM(
+    var ex;
+
+    // enough nodes to make the name table grow several times
+    FS.mkdir('/many');
+    for (var i = 0; i < 100; i++) {
+      FS.mkdir('/many/d' + i);
+      for (var j = 0; j < 200; j++) {
+        FS.writeFile('/many/d' + i + '/f' + j, i + ',' + j);
+      }
+    }
+    assert(FS.nameTable.length > 4096);
+    for (var i = 0; i < 100; i++) {
+      for (var j = 0; j < 200; j++) {
+        assert(FS.readFile('/many/d' + i + '/f' + j, { encoding: 'utf8' }) === i + ',' + j);
+      }
+    }
+
+    // renaming a directory moves everything below it
+    FS.stat('/many/d1/f1');
+    FS.rename('/many/d1', '/many/renamed');
+    try {
+      FS.stat('/many/d1/f1');
+    } catch (e) {
+      ex = e;
+    }
+    assert(ex instanceof FS.ErrnoError && ex.errno === ERRNO_CODES.ENOENT);
+    assert(FS.readFile('/many/renamed/f1', { encoding: 'utf8' }) === '1,1');
+
+    // unlinked files are gone
+    ex = null;
+    FS.unlink('/many/d2/f2');
+    try {
+      FS.stat('/many/d2/f2');
+    } catch (e) {
+      ex = e;
+    }
+    assert(ex instanceof FS.ErrnoError && ex.errno === ERRNO_CODES.ENOENT);
+
+    // replacing a symlink changes where it leads
+    FS.symlink('/many/d3', '/link');
+    assert(FS.readFile('/link/f3', { encoding: 'utf8' }) === '3,3');
+    FS.unlink('/link');
+    FS.symlink('/many/d4', '/link');
+    assert(FS.readFile('/link/f3', { encoding: 'utf8' }) === '4,3');
+
+    // a mount hides what was below the mountpoint, and unmounting shows it again
+    ex = null;
+    FS.mount(MEMFS, {}, '/many/d5');
+    try {
+      FS.stat('/many/d5/f5');
+    } catch (e) {
+      ex = e;
+    }
+    assert(ex instanceof FS.ErrnoError && ex.errno === ERRNO_CODES.ENOENT);
+    FS.unmount('/many/d5');
+    assert(FS.readFile('/many/d5/f5', { encoding: 'utf8' }) === '5,5');
+
+    // a directory that may no longer be searched refuses lookups through it
+    ex = null;
+    FS.chmod('/many/d6', 0);
+    try {
+      FS.stat('/many/d6/f6');
+    } catch (e) {
+      ex = e;
+    }
+    assert(ex instanceof FS.ErrnoError && ex.errno === ERRNO_CODES.EACCES);
+  );
+
+  puts("success");
+
+  return 0;
+}
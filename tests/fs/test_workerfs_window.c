@@ -0,0 +1,79 @@
+#include <emscripten.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// the blob is SIZE bytes, byte i being (i * 7 + (i >> 11)) & 255
+#define SIZE (4*1024*1024 + 123)
+
+int result = 1;
+
+unsigned char expected(int i) {
+  return (i * 7 + (i >> 11)) & 255;
+}
+
+int check(const unsigned char *buf, int pos, int n) {
+  for (int i = 0; i < n; i++) {
+    if (buf[i] != expected(pos + i)) return 0;
+  }
+  return 1;
+}
+
+int slices() {
+  return EM_ASM_INT_V({ return Module['slicesRead']; });
+}
+
+int main() {
+  static unsigned char buf[64*1024];
+  int fd = open("/work/big.bin", O_RDONLY);
+  if (fd == -1) {
+    result = -1000;
+    goto exit;
+  }
+
+  // reading straight through in small pieces takes a few large slices of the file
+  int pos = 0, n;
+  while ((n = read(fd, buf, 4096)) > 0) {
+    if (!check(buf, pos, n)) {
+      result = -2000;
+      goto exit;
+    }
+    pos += n;
+  }
+  printf("sequential: %d slices\n", slices());
+  if (pos != SIZE || slices() > 20) {
+    result = -3000;
+    goto exit;
+  }
+
+  // random reads take just the blocks they need, and reads within them take nothing more
+  for (int i = 0; i < 100; i++) {
+    pos = (i * 104729) % (SIZE - 200);
+    if (lseek(fd, pos, SEEK_SET) != pos || read(fd, buf, 100) != 100 || !check(buf, pos, 100)) {
+      result = -4000;
+      goto exit;
+    }
+  }
+  int before = slices();
+  if (lseek(fd, pos + 1, SEEK_SET) != pos + 1 || read(fd, buf, 10) != 10 || !check(buf, pos + 1, 10) || slices() != before) {
+    result = -5000;
+    goto exit;
+  }
+
+  // reads across the end of the window, and past the end of the file
+  pos = 4096 - 10;
+  if (lseek(fd, pos, SEEK_SET) != pos || read(fd, buf, 60000) != 60000 || !check(buf, pos, 60000)) {
+    result = -6000;
+    goto exit;
+  }
+  pos = SIZE - 10;
+  if (lseek(fd, pos, SEEK_SET) != pos || read(fd, buf, 100) != 10 || !check(buf, pos, 10)) {
+    result = -7000;
+    goto exit;
+  }
+
+exit:
+  REPORT_RESULT(result);
+}
@@ -0,0 +1,224 @@
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+// Echoes many small messages off a server, first with one send()/recv() per
+// message and then in batches with sendmmsg()/recvmmsg(), and times both.
+
+#define MESSAGES 4096
+#define MESSAGE_SIZE 16
+#define BATCH 64
+#define TOTAL (MESSAGES * MESSAGE_SIZE)
+
+typedef enum {
+  SINGLE,
+  BATCHED,
+  DONE
+} phase_t;
+
+int fd;
+phase_t phase = SINGLE;
+int sent, received;
+double start;
+
+// every byte of the stream is checked on the way back, whatever framing it arrives in
+unsigned char pattern(int offset) {
+  return offset % 251;
+}
+
+void finish(int result) {
+  if (fd) {
+    close(fd);
+    fd = 0;
+  }
+#ifdef __EMSCRIPTEN__
+#ifdef REPORT_RESULT
+  REPORT_RESULT(result);
+#endif
+  emscripten_force_exit(result);
+#else
+  exit(result);
+#endif
+}
+
+double now() {
+#ifdef __EMSCRIPTEN__
+  return emscripten_get_now();
+#else
+  return 0;
+#endif
+}
+
+void check(unsigned char *data, int length) {
+  for (int i = 0; i < length; i++) {
+    if (data[i] != pattern(received + i)) {
+      printf("mismatch at byte %d\n", received + i);
+      finish(EXIT_FAILURE);
+    }
+  }
+  received += length;
+}
+
+void send_single() {
+  unsigned char message[MESSAGE_SIZE];
+  while (sent < TOTAL) {
+    for (int i = 0; i < MESSAGE_SIZE; i++) message[i] = pattern(sent + i);
+    int res = send(fd, message, MESSAGE_SIZE, 0);
+    if (res == -1) {
+      assert(errno == EAGAIN);
+      return;
+    }
+    assert(res == MESSAGE_SIZE);
+    sent += res;
+  }
+}
+
+void recv_single() {
+  unsigned char message[MESSAGE_SIZE];
+  while (received < TOTAL) {
+    int res = recv(fd, message, MESSAGE_SIZE, 0);
+    if (res == -1) {
+      assert(errno == EAGAIN);
+      return;
+    } else if (res == 0) {
+      printf("server closed\n");
+      finish(EXIT_FAILURE);
+    }
+    check(message, res);
+  }
+}
+
+void send_batched() {
+  static unsigned char messages[BATCH][MESSAGE_SIZE];
+  static struct iovec iovs[BATCH];
+  static struct mmsghdr msgs[BATCH];
+  while (sent < TOTAL) {
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < BATCH; i++) {
+      for (int j = 0; j < MESSAGE_SIZE; j++) messages[i][j] = pattern(sent + i * MESSAGE_SIZE + j);
+      iovs[i].iov_base = messages[i];
+      iovs[i].iov_len = MESSAGE_SIZE;
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int res = sendmmsg(fd, msgs, BATCH, 0);
+    if (res == -1) {
+      assert(errno == EAGAIN);
+      return;
+    }
+    assert(res == BATCH);
+    for (int i = 0; i < res; i++) {
+      assert(msgs[i].msg_len == MESSAGE_SIZE);
+      sent += msgs[i].msg_len;
+    }
+  }
+}
+
+void recv_batched() {
+  static unsigned char messages[BATCH][1024];
+  static struct iovec iovs[BATCH];
+  static struct mmsghdr msgs[BATCH];
+  while (received < TOTAL) {
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < BATCH; i++) {
+      iovs[i].iov_base = messages[i];
+      iovs[i].iov_len = sizeof(messages[i]);
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int res = recvmmsg(fd, msgs, BATCH, 0, NULL);
+    if (res == -1) {
+      assert(errno == EAGAIN);
+      return;
+    }
+    for (int i = 0; i < res; i++) {
+      if (!msgs[i].msg_len) {
+        printf("server closed\n");
+        finish(EXIT_FAILURE);
+      }
+      check(messages[i], msgs[i].msg_len);
+    }
+  }
+}
+
+void main_loop() {
+  fd_set fdr;
+  fd_set fdw;
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  FD_SET(fd, &fdr);
+  FD_SET(fd, &fdw);
+  if (select(64, &fdr, &fdw, NULL, NULL) == -1) {
+    perror("select failed");
+    finish(EXIT_FAILURE);
+  }
+
+  if (sent < TOTAL) {
+    if (!FD_ISSET(fd, &fdw)) return;
+    if (!sent) start = now();
+    if (phase == SINGLE) send_single();
+    else send_batched();
+  }
+
+  if (FD_ISSET(fd, &fdr)) {
+    if (phase == SINGLE) recv_single();
+    else recv_batched();
+  }
+
+  if (received == TOTAL) {
+    printf("%s: echoed %d messages of %d bytes in %.2f ms\n", phase == SINGLE ? "send/recv" : "sendmmsg/recvmmsg", MESSAGES, MESSAGE_SIZE, now() - start);
+    sent = received = 0;
+    phase++;
+    if (phase == DONE) {
+      finish(EXIT_SUCCESS);
+    }
+  }
+}
+
+int main() {
+  struct sockaddr_in addr;
+  int res;
+
+  fd = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (fd == -1) {
+    perror("cannot create socket");
+    finish(EXIT_FAILURE);
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(SOCKK);
+  if (inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr) != 1) {
+    perror("inet_pton failed");
+    finish(EXIT_FAILURE);
+  }
+
+  res = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+  if (res == -1 && errno != EINPROGRESS) {
+    perror("connect failed");
+    finish(EXIT_FAILURE);
+  }
+
+#ifdef __EMSCRIPTEN__
+  emscripten_set_main_loop(main_loop, 0, 0);
+#else
+  while (1) main_loop();
+#endif
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+// A plain blocking TCP echo server, for timing clients that talk to it through websockify.
+int main() {
+  struct sockaddr_in addr;
+  char buffer[64*1024];
+  int serverfd, clientfd, on = 1;
+  ssize_t res;
+
+  serverfd = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (serverfd == -1) {
+    perror("cannot create socket");
+    exit(EXIT_FAILURE);
+  }
+  setsockopt(serverfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(SOCKK);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(serverfd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+    perror("bind failed");
+    exit(EXIT_FAILURE);
+  }
+  if (listen(serverfd, 50) == -1) {
+    perror("listen failed");
+    exit(EXIT_FAILURE);
+  }
+
+  // websockify's startup check connects and hangs up first, so keep serving
+  while (1) {
+    clientfd = accept(serverfd, NULL, NULL);
+    if (clientfd == -1) {
+      perror("accept failed");
+      exit(EXIT_FAILURE);
+    }
+    while ((res = read(clientfd, buffer, sizeof(buffer))) > 0) {
+      char *pos = buffer;
+      while (res > 0) {
+        ssize_t wrote = write(clientfd, pos, res);
+        if (wrote <= 0) break;
+        pos += wrote;
+        res -= wrote;
+      }
+    }
+    close(clientfd);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -840,6 +840,36 @@ class benchmark(RunnerCore):
       return float(re.search('Total time: ([\d\.]+)', output).group(1))
     self.do_benchmark('memcpy_16mb', open(path_from_root('tests', 'benchmark_memcpy.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMIN_COPY=1048576', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
 
+  def test_memcpy_misaligned_128b(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('memcpy_misaligned_128b', open(path_from_root('tests', 'benchmark_memcpy.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMAX_COPY=128', '-DSRC_OFFSET=1', '-DDST_OFFSET=3', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_memcpy_misaligned_4k(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('memcpy_misaligned_4k', open(path_from_root('tests', 'benchmark_memcpy.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMIN_COPY=128', '-DMAX_COPY=4096', '-DSRC_OFFSET=1', '-DDST_OFFSET=3', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_memmove_overlap_forward_4k(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('memmove_overlap_forward_4k', open(path_from_root('tests', 'benchmark_memcpy.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMAX_COPY=4096', '-DOVERLAP=-16', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_memmove_overlap_backward_4k(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('memmove_overlap_backward_4k', open(path_from_root('tests', 'benchmark_memcpy.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMAX_COPY=4096', '-DOVERLAP=16', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_memmove_overlap_backward_misaligned_4k(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('memmove_overlap_backward_misaligned_4k', open(path_from_root('tests', 'benchmark_memcpy.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMAX_COPY=4096', '-DOVERLAP=3', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
   def test_memset_128b(self):
     if CORE_BENCHMARKS: return
     def output_parser(output):
@@ -870,6 +900,66 @@ class benchmark(RunnerCore):
       return float(re.search('Total time: ([\d\.]+)', output).group(1))
     self.do_benchmark('memset_16mb', open(path_from_root('tests', 'benchmark_memset.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMIN_COPY=1048576', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
 
+  def test_memset_misaligned_128b(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('memset_misaligned_128b', open(path_from_root('tests', 'benchmark_memset.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMAX_COPY=128', '-DDST_OFFSET=1', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_memset_misaligned_4k(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('memset_misaligned_4k', open(path_from_root('tests', 'benchmark_memset.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DMIN_COPY=128', '-DMAX_COPY=4096', '-DDST_OFFSET=1', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_string_memcmp(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('string_memcmp', open(path_from_root('tests', 'benchmark_strings.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DSTRING_FUNCTION=STRING_MEMCMP', '-DMAX_COPY=16384', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_string_memcmp_misaligned(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('string_memcmp_misaligned', open(path_from_root('tests', 'benchmark_strings.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DSTRING_FUNCTION=STRING_MEMCMP', '-DMAX_COPY=16384', '-DSRC_OFFSET=1', '-DDST_OFFSET=3', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_string_memchr(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('string_memchr', open(path_from_root('tests', 'benchmark_strings.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DSTRING_FUNCTION=STRING_MEMCHR', '-DMAX_COPY=16384', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_string_strlen(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('string_strlen', open(path_from_root('tests', 'benchmark_strings.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DSTRING_FUNCTION=STRING_STRLEN', '-DMAX_COPY=16384', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_string_strlen_misaligned(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('string_strlen_misaligned', open(path_from_root('tests', 'benchmark_strings.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DSTRING_FUNCTION=STRING_STRLEN', '-DMAX_COPY=16384', '-DSRC_OFFSET=5', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_string_strcmp(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('string_strcmp', open(path_from_root('tests', 'benchmark_strings.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DSTRING_FUNCTION=STRING_STRCMP', '-DMAX_COPY=16384', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_string_strcmp_misaligned(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('string_strcmp_misaligned', open(path_from_root('tests', 'benchmark_strings.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DSTRING_FUNCTION=STRING_STRCMP', '-DMAX_COPY=16384', '-DSRC_OFFSET=1', '-DDST_OFFSET=3', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
+  def test_string_strchr(self):
+    if CORE_BENCHMARKS: return
+    def output_parser(output):
+      return float(re.search('Total time: ([\d\.]+)', output).group(1))
+    self.do_benchmark('string_strchr', open(path_from_root('tests', 'benchmark_strings.cpp')).read(), '''Total time:''', output_parser=output_parser, shared_args=['-DSTRING_FUNCTION=STRING_STRCHR', '-DMAX_COPY=16384', '-DBUILD_FOR_SHELL', '-I'+path_from_root('tests')])
+
   def test_matrix_multiply(self):
     def output_parser(output):
       return float(re.search('Total elapsed: ([\d\.]+)', output).group(1))
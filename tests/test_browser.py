@@ -450,6 +450,39 @@ If manually bisecting:
     self.run_browser('page.html', 'You should see |load me right before|.', '/report_result?1')
     self.run_browser('page.html', 'You should see |load me right before|.', '/report_result?2')
 
+  def test_preload_caching_delta(self):
+    # when the package changes, only the parts of it that are not cached yet are downloaded
+    open(os.path.join(self.get_dir(), 'somefile.txt'), 'w').write('''load me right before running the code please''')
+    open(os.path.join(self.get_dir(), 'big.dat'), 'wb').write(os.urandom(3*1024*1024))
+    open(os.path.join(self.get_dir(), 'main.cpp'), 'w').write(self.with_report_result(r'''
+      #include <stdio.h>
+      #include <emscripten.h>
+
+      int main(int argc, char** argv) {
+        FILE *f = fopen("somefile.txt", "r");
+        char buf[100];
+        buf[fread(buf, 1, 99, f)] = 0;
+        fclose(f);
+        printf("|%s|\n", buf);
+
+        // 0 if the whole package was downloaded, 1 if it all came from the cache, 2 if just a small part was downloaded
+        int result = EM_ASM_INT_V({
+          var results = Module['preloadResults']['page.data'];
+          return results['fromCache'] ? 1 : results['downloaded'] < 1024*1024 ? 2 : 0;
+        });
+        REPORT_RESULT(result);
+        return 0;
+      }
+    '''))
+    def build():
+      Popen([PYTHON, EMCC, os.path.join(self.get_dir(), 'main.cpp'), '--use-preload-cache', '--preload-file', 'somefile.txt', '--preload-file', 'big.dat', '-o', 'page.html']).communicate()
+    build()
+    self.run_browser('page.html', 'You should see |load me right before running the code please|.', '/report_result?0')
+    self.run_browser('page.html', 'You should see |load me right before running the code please|.', '/report_result?1')
+    open(os.path.join(self.get_dir(), 'somefile.txt'), 'w').write('''load me, changed''')
+    build()
+    self.run_browser('page.html', 'You should see |load me, changed|.', '/report_result?2')
+
   def test_multifile(self):
     # a few files inside a directory
     self.clear()
@@ -1285,6 +1318,27 @@ keydown(100);keyup(100); // trigger the end
     ''' % (secret, secret2))
     self.btest(path_from_root('tests', 'fs', 'test_workerfs_read.c'), '1', force_c=True, args=['-lworkerfs.js', '--pre-js', 'pre.js', '-DSECRET=\"' + secret + '\"', '-DSECRET2=\"' + secret2 + '\"', '--proxy-to-worker'])
 
+  def test_fs_workerfs_read_window(self):
+    open(self.in_dir('pre.js'), 'w').write('''
+      var Module = {};
+      Module.preRun = function() {
+        var size = 4*1024*1024 + 123;
+        var data = new Uint8Array(size);
+        for (var i = 0; i < size; i++) data[i] = (i * 7 + (i >> 11)) & 255;
+        FS.mkdir('/work');
+        FS.mount(WORKERFS, {
+          blobs: [{ name: 'big.bin', data: new Blob([data]) }],
+        }, '/work');
+        Module['slicesRead'] = 0;
+        var readAsArrayBuffer = WORKERFS.reader.readAsArrayBuffer;
+        WORKERFS.reader.readAsArrayBuffer = function(blob) {
+          Module['slicesRead']++;
+          return readAsArrayBuffer.call(WORKERFS.reader, blob);
+        };
+      };
+    ''')
+    self.btest(path_from_root('tests', 'fs', 'test_workerfs_window.c'), '1', force_c=True, args=['-lworkerfs.js', '--pre-js', 'pre.js', '--proxy-to-worker'])
+
   def test_fs_workerfs_package(self):
     open('file1.txt', 'w').write('first')
     if not os.path.exists('sub'): os.makedirs('sub')
@@ -3321,6 +3375,10 @@ window.close = function() {
   def test_pthread_malloc_free(self):
     self.btest(path_from_root('tests', 'pthread', 'test_pthread_malloc_free.cpp'), expected='0', args=['-s', 'TOTAL_MEMORY=64MB', '-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8', '-s', 'TOTAL_MEMORY=256MB'], timeout=30)
 
+  # Test that memory allocated on one thread and freed on another works with the per-thread malloc caches.
+  def test_pthread_malloc_free_thread_cache(self):
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_malloc_free.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8', '-s', 'TOTAL_MEMORY=256MB', '-s', 'MALLOC_THREAD_CACHE=1'], timeout=30)
+
   # Test that the pthread_barrier API works ok.
   def test_pthread_barrier(self):
     self.btest(path_from_root('tests', 'pthread', 'test_pthread_barrier.cpp'), expected='0', args=['-s', 'TOTAL_MEMORY=64MB', '-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8'], timeout=30)
@@ -3678,7 +3736,7 @@ window.close = function() {
     self.run_browser('test.html', '', '/report_result?0')
 
   def test_utf8_textdecoder(self):
-    self.btest('benchmark_utf8.cpp', expected='0', args=['--embed-file', path_from_root('tests/utf8_corpus.txt') + '@/utf8_corpus.txt', '-s', 'EXTRA_EXPORTED_RUNTIME_METHODS=["UTF8ToString"]'])
+    self.btest('benchmark_utf8.cpp', expected='0', args=['--embed-file', path_from_root('tests/utf8_corpus.txt') + '@/utf8_corpus.txt', '-s', 'EXTRA_EXPORTED_RUNTIME_METHODS=["UTF8ToString","stringToUTF8","lengthBytesUTF8"]'])
 
   def test_utf16_textdecoder(self):
     self.btest('benchmark_utf16.cpp', expected='0', args=['--embed-file', path_from_root('tests/utf16_corpus.txt') + '@/utf16_corpus.txt', '-s', 'EXTRA_EXPORTED_RUNTIME_METHODS=["UTF16ToString","stringToUTF16","lengthBytesUTF16"]'])
@@ -3710,6 +3768,11 @@ window.close = function() {
     shutil.copyfile(path_from_root('tests', 'gears.png'), os.path.join(self.get_dir(), 'gears.png'))
     self.btest('fetch/cached_xhr.cpp', expected='1', args=['--std=c++11', '-s', 'FETCH_DEBUG=1', '-s', 'FETCH=1'])
 
+  # Tests emscripten_fetch() usage to XHR data into a ring of caller-provided buffers without the fetch allocating any of its own.
+  def test_fetch_to_destination_buffers(self):
+    shutil.copyfile(path_from_root('tests', 'gears.png'), os.path.join(self.get_dir(), 'gears.png'))
+    self.btest('fetch/to_destination_buffers.cpp', expected='1', args=['--std=c++11', '-s', 'FETCH_DEBUG=1', '-s', 'FETCH=1'])
+
   # Test emscripten_fetch() usage to stream a XHR in to memory without storing the full file in memory
   def test_fetch_stream_file(self):
     # Strategy: create a large 128MB file, and compile with a small 16MB Emscripten heap, so that the tested file
@@ -3728,6 +3791,10 @@ window.close = function() {
     shutil.copyfile(path_from_root('tests', 'gears.png'), os.path.join(self.get_dir(), 'gears.png'))
     self.btest('fetch/sync_xhr.cpp', expected='1', args=['--std=c++11', '-s', 'FETCH_DEBUG=1', '-s', 'FETCH=1', '-s', 'USE_PTHREADS=1', '-s', 'PROXY_TO_PTHREAD=1'])
 
+  def test_fetch_many_waitable_fetches(self):
+    shutil.copyfile(path_from_root('tests', 'gears.png'), os.path.join(self.get_dir(), 'gears.png'))
+    self.btest('fetch/many_waitable_fetches.cpp', expected='0', args=['-s', 'USE_PTHREADS=1', '-s', 'PTHREAD_POOL_SIZE=4', '-s', 'FETCH=1', '-s', 'PROXY_TO_PTHREAD=1'])
+
   def test_fetch_idb_store(self):
     self.btest('fetch/idb_store.cpp', expected='0', args=['-s', 'USE_PTHREADS=1', '-s', 'FETCH_DEBUG=1', '-s', 'FETCH=1', '-s', 'PROXY_TO_PTHREAD=1'])
 
@@ -3748,6 +3815,12 @@ window.close = function() {
   def test_asmfs_fopen_write(self):
     self.btest('asmfs/fopen_write.cpp', expected='0', args=['-s', 'ASMFS=1', '-s', 'USE_PTHREADS=1', '-s', 'FETCH_DEBUG=1'])
 
+  def test_asmfs_sparse_write(self):
+    self.btest('asmfs/sparse_write.cpp', expected='0', args=['-s', 'ASMFS=1', '-s', 'USE_PTHREADS=1', '-s', 'FETCH_DEBUG=1'])
+
+  def test_asmfs_printf_throughput(self):
+    self.btest('benchmark_printf.cpp', expected='0', args=['-s', 'ASMFS=1', '-s', 'USE_PTHREADS=1', '-s', 'PROXY_TO_PTHREAD=1'])
+
   def test_asmfs_mkdir_create_unlink_rmdir(self):
     self.btest('cstdio/test_remove.cpp', expected='0', args=['-s', 'ASMFS=1', '-s', 'USE_PTHREADS=1', '-s', 'FETCH_DEBUG=1'])
 
@@ -690,6 +690,9 @@ base align: 0, 0, 0, 0'''])
   def test_strndup(self):
     self.do_run_in_out_file_test('tests', 'core', 'test_strndup')
 
+  def test_string_words(self):
+    self.do_run_in_out_file_test('tests', 'core', 'test_string_words')
+
   def test_errar(self):
     self.do_run_in_out_file_test('tests', 'core', 'test_errar')
 
@@ -1793,6 +1796,15 @@ int main(int argc, char **argv) {
     self.emcc_args += ['-s', 'ALLOW_MEMORY_GROWTH=1', '-DFAIL_REALLOC_BUFFER']
     self.do_run_in_out_file_test('tests', 'core', 'test_memorygrowth_3')
 
+  def test_memorygrowth_reserve(self):
+    self.emcc_args += ['-s', 'ALLOW_MEMORY_GROWTH=1', '-s', 'MEMORY_GROWTH_GEOMETRIC_CAP=' + str(16*1024*1024)]
+    self.do_run_in_out_file_test('tests', 'core', 'test_memorygrowth_reserve')
+
+  def test_malloc_large_region(self):
+    if self.is_split_memory(): return self.skip('split memory has no large chunk region')
+    self.emcc_args += ['-s', 'MALLOC_LARGE_OBJECT_REGION=1', '-s', 'ALLOW_MEMORY_GROWTH=1']
+    self.do_run_in_out_file_test('tests', 'core', 'test_malloc_large_region')
+
   def test_ssr(self): # struct self-ref
       src = '''
         #include <stdio.h>
@@ -2241,6 +2253,9 @@ The current type of b is: 9
   def test_memset_alignment(self):
     self.do_run(open(path_from_root('tests', 'test_memset_alignment.cpp'), 'r').read(), 'OK.')
 
+  def test_memmove_alignment(self):
+    self.do_run(open(path_from_root('tests', 'test_memmove_alignment.cpp'), 'r').read(), 'OK.')
+
   def test_memset(self):
     self.do_run_in_out_file_test('tests', 'core', 'test_memset')
 
@@ -4238,7 +4253,7 @@ def process(filename):
 
     mem_file = 'src.cpp.o.js.mem'
     orig_args = self.emcc_args
-    for mode in [[], ['-s', 'MEMFS_APPEND_TO_TYPED_ARRAYS=1'], ['-s', 'SYSCALL_DEBUG=1']]:
+    for mode in [[], ['-s', 'MEMFS_APPEND_TO_TYPED_ARRAYS=1'], ['-s', 'MEMFS_CHUNK_SIZE=64'], ['-s', 'SYSCALL_DEBUG=1']]:
       print(mode)
       self.emcc_args = orig_args + mode
       try_delete(mem_file)
@@ -4289,6 +4304,23 @@ def process(filename):
     src = open(path_from_root('tests', 'fs', 'test_mount.c'), 'r').read()
     self.do_run(src, 'success', force_c=True)
 
+  def test_fs_memfs_chunks(self):
+    self.emcc_args += ['-s', 'MEMFS_CHUNK_SIZE=4096']
+    src = open(path_from_root('tests', 'fs', 'test_memfs_chunks.c'), 'r').read()
+    self.do_run(src, 'success', force_c=True)
+
+  def test_fs_lz4fs_cache(self):
+    Settings.FORCE_FILESYSTEM = 1
+    Settings.LZ4 = 1
+    Settings.LZ4_CACHE_SIZE = 16384
+    src = open(path_from_root('tests', 'fs', 'test_lz4fs_cache.c'), 'r').read()
+    self.do_run(src, 'random: 8\nstream: 40\nrandom again: 42\nsuccess', force_c=True)
+
+  def test_fs_path_cache(self):
+    Settings.FORCE_FILESYSTEM = 1
+    src = open(path_from_root('tests', 'fs', 'test_path_cache.c'), 'r').read()
+    self.do_run(src, 'success', force_c=True)
+
   def test_getdents64(self):
     src = open(path_from_root('tests', 'fs', 'test_getdents64.cpp'), 'r').read()
     self.do_run(src, '..')
@@ -4310,7 +4342,7 @@ def process(filename):
     src, output = (test_path + s for s in ('.c', '.out'))
 
     orig_args = self.emcc_args
-    for mode in [[], ['-s', 'MEMFS_APPEND_TO_TYPED_ARRAYS=1']]:
+    for mode in [[], ['-s', 'MEMFS_APPEND_TO_TYPED_ARRAYS=1'], ['-s', 'MEMFS_CHUNK_SIZE=64']]:
       self.emcc_args = orig_args + mode
       self.do_run_from_file(src, output)
 
@@ -4540,7 +4572,7 @@ def process(filename):
     self.do_run(open(path_from_root('tests', 'utf8.cpp')).read(), 'OK.')
 
   def test_utf8_textdecoder(self):
-    Settings.EXTRA_EXPORTED_RUNTIME_METHODS = ['UTF8ToString', 'stringToUTF8']
+    Settings.EXTRA_EXPORTED_RUNTIME_METHODS = ['UTF8ToString', 'stringToUTF8', 'lengthBytesUTF8']
     Building.COMPILER_TEST_OPTS += ['--embed-file', path_from_root('tests/utf8_corpus.txt')+ '@/utf8_corpus.txt']
     self.do_run(open(path_from_root('tests', 'benchmark_utf8.cpp')).read(), 'OK.')
 
@@ -0,0 +1,55 @@
+#include <memory.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+char buf[1024*256+256] = {};
+char ref[1024*256+256] = {};
+
+#define GUARDSIZE 64
+void test_memmove(int copySize, int srcOffset, int dstOffset)
+{
+	int total = copySize + 2*GUARDSIZE + 16;
+	char *srcContent = buf + GUARDSIZE + srcOffset;
+	char *dstContent = buf + GUARDSIZE + dstOffset;
+
+	char s = (char)rand();
+	for(int i = 0; i < total; ++i)
+		buf[i] = ref[i] = (char)(s - i);
+
+	// The expected result, copied a byte at a time in the safe direction.
+	char *refSrc = ref + GUARDSIZE + srcOffset;
+	char *refDst = ref + GUARDSIZE + dstOffset;
+	if (refDst < refSrc)
+		for(int i = 0; i < copySize; ++i) refDst[i] = refSrc[i];
+	else
+		for(int i = copySize - 1; i >= 0; --i) refDst[i] = refSrc[i];
+
+	if (memmove(dstContent, srcContent, copySize) != dstContent || !!memcmp(buf, ref, total))
+	{
+		printf("test_memmove(copySize=%d, srcOffset=%d, dstOffset=%d) failed!\n", copySize, srcOffset, dstOffset);
+		exit(1);
+	}
+}
+
+void test_copysize(int copySize)
+{
+	// Overlapping moves in both directions, by distances that keep or break the alignment between source and destination.
+	int offsets[8] = { 0, 1, 3, 4, 5, 8, 16, 33 };
+
+	for(int srcOffset = 0; srcOffset < 8; ++srcOffset)
+		for(int dstOffset = 0; dstOffset < 8; ++dstOffset)
+			test_memmove(copySize, offsets[srcOffset], offsets[dstOffset]);
+}
+
+int main()
+{
+	for(int copySize = 0; copySize < 160; ++copySize)
+		test_copysize(copySize);
+
+	for(int copySizeI = 256; copySizeI <= 1024*256; copySizeI <<= 1)
+		for(int copySizeJ = 1; copySizeJ <= 16; copySizeJ <<= 1)
+			test_copysize(copySizeI | copySizeJ);
+
+	printf("OK.\n");
+}
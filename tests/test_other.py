@@ -2023,6 +2023,28 @@ int f() {
         output = run_process([js_optimizer.get_native_optimizer(), input] + passes, stdin=PIPE, stdout=PIPE).stdout
         check_js(output, expected)
 
+  def test_js_optimizer_chunking(self):
+    import tools.js_optimizer
+    def func(name, size):
+      return (name, 'function %s() {\n%s\n}\n' % (name, 'x' * size))
+    funcs = [func('_f%d' % i, (i % 10 + 1) * 10000) for i in range(300)]
+    funcs.insert(100, func('_big', 2*1024*1024))
+    everything = ''.join(f[1] for f in funcs)
+
+    for cores in [4, 16]:
+      print(cores)
+      chunks = tools.js_optimizer.chunk_funcs(funcs, cores)
+      assert sorted(''.join(c[1] for c in chunks)) == sorted(everything)
+      # the big function is optimized alone, and the rest are spread out evenly
+      big = [c for c in chunks if '_big' in c[1]]
+      assert len(big) == 1 and big[0][1] == funcs[100][1], big
+      costs = [c[0] for c in chunks if c not in big]
+      assert max(costs) - min(costs) < 100000, costs
+
+      # when the output is not sorted, chunks must keep the input order
+      ordered = tools.js_optimizer.chunk_funcs(funcs, cores, keep_order=True)
+      self.assertEqual(''.join(c[1] for c in ordered), everything)
+
   def test_m_mm(self):
     open(os.path.join(self.get_dir(), 'foo.c'), 'w').write('''#include <emscripten.h>''')
     for opt in ['M', 'MM']:
@@ -2101,6 +2123,8 @@ int f() {
     ]
     test_cases.extend([ (args[:] + ['-s', 'NO_DYNAMIC_EXECUTION=1'], status) for args, status in test_cases])
     test_cases.append((['--bind', '-O2', '--closure', '1'], False)) # closure compiler doesn't work with NO_DYNAMIC_EXECUTION=1
+    test_cases.append((['--bind', '-O2', '-s', 'EMBIND_STATIC_INVOKERS=1', '-s', 'NO_DYNAMIC_EXECUTION=1'], False))
+    test_cases.append((['--bind', '-O2', '--closure', '1', '-s', 'EMBIND_STATIC_INVOKERS=1'], False))
     test_cases = [(args + ['-s', 'IN_TEST_HARNESS=1'], status) for args, status in test_cases]
 
     for args, fail in test_cases:
@@ -2288,6 +2312,38 @@ seeked= file.
     assert unicode_name in proc.stdout, proc.stdout
     print(len(proc.stderr))
 
+  def test_file_packager_dedup_chunks(self):
+    import hashlib, json
+    open('data1.txt', 'w').write('data1')
+    open('copy.txt', 'w').write('data1')
+    big = os.urandom(2*1024*1024 + 1000)
+    open('big.dat', 'wb').write(big)
+    def package():
+      run_process([PYTHON, FILE_PACKAGER, 'test.data', '--preload', 'data1.txt', 'copy.txt', 'big.dat', '--use-preload-cache', '--js-output=pkg.js', '--separate-metadata'])
+      return json.load(open('pkg.js.metadata'))
+    metadata = package()
+    # identical files are stored once
+    files = dict((f['filename'], f) for f in metadata['files'])
+    assert (files['/copy.txt']['start'], files['/copy.txt']['end']) == (files['/data1.txt']['start'], files['/data1.txt']['end'])
+    assert files['/copy.txt'].get('shared') and not files['/data1.txt'].get('shared')
+    assert os.path.getsize('test.data') == len('data1') + len(big)
+    # the chunks cover the package, and are named by their contents
+    data = open('test.data', 'rb').read()
+    chunks = metadata['chunks']
+    assert chunks[0]['start'] == 0 and chunks[-1]['end'] == len(data)
+    for prev, curr in zip(chunks, chunks[1:]):
+      assert prev['end'] == curr['start']
+    for chunk in chunks:
+      assert chunk['hash'] == hashlib.sha256(data[chunk['start']:chunk['end']]).hexdigest()
+    def big_chunks(metadata):
+      start = [f for f in metadata['files'] if f['filename'] == '/big.dat'][0]['start']
+      return [chunk['hash'] for chunk in metadata['chunks'] if chunk['start'] >= start]
+    # changing another file moves the big one, but its chunks stay the same, so a cache still has them
+    before = big_chunks(metadata)
+    assert len(before) == 3
+    open('data1.txt', 'w').write('data1, changed')
+    assert big_chunks(package()) == before
+
   def test_crunch(self):
     try:
       print('Crunch is located at ' + CRUNCH)
@@ -6616,6 +6672,98 @@ int main() {
   assert(bad == -1);
   EM_ASM( Module.print('success.') );
 }
+''')
+    for opts in [0, 1, 2]:
+      print(opts)
+      check_execute([PYTHON, EMCC, 'src.c', '-s', 'SPLIT_MEMORY=8388608', '-s', 'TOTAL_MEMORY=64MB', '-O' + str(opts)])
+      self.assertContained('success.', run_js('a.out.js'))
+
+  def test_malloc_heap_profiler(self):
+    open('src.c', 'w').write(r'''
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <emscripten/heap_profiler.h>
+
+void *kept[100];
+
+__attribute__((noinline)) void keep_some_memory() {
+  for (int i = 0; i < 100; i++) kept[i] = malloc(64*1024);
+}
+
+__attribute__((noinline)) void churn_some_memory() {
+  for (int i = 0; i < 100; i++) free(malloc(64*1024));
+}
+
+__attribute__((noinline)) void shrink_some_memory() {
+  for (int i = 0; i < 100; i++) assert(realloc(kept[i], 60*1024) == kept[i]);
+}
+
+int main() {
+  emscripten_heap_profiler_set_sample_interval(4096);
+  keep_some_memory();
+  churn_some_memory();
+  shrink_some_memory();
+  assert(emscripten_heap_profiler_dump("heap.prof") == 0);
+  FILE *f = fopen("heap.prof", "r");
+  assert(f);
+  static char profile[64*1024];
+  profile[fread(profile, 1, sizeof(profile) - 1, f)] = 0;
+  fclose(f);
+  assert(strstr(profile, "--- symbol\n"));
+  char *header = strstr(profile, "heap profile: ");
+  assert(header);
+  int live_count, live_bytes, alloc_count, alloc_bytes, interval;
+  assert(sscanf(header, "heap profile: %d: %d [%d: %d] @ heap_v2/%d", &live_count, &live_bytes, &alloc_count, &alloc_bytes, &interval) == 5);
+  // every allocation is far past the sample interval, so all of them are sampled, and only the kept ones are live,
+  // at the size they were shrunk to
+  printf("live %d (%d bytes), allocated %d, interval %d\n", live_count, live_bytes, alloc_count, interval);
+  assert(live_count == 100 && live_bytes == 100*60*1024 && alloc_count == 300);
+  assert(strstr(profile, "keep_some_memory"));
+  assert(strstr(profile, "churn_some_memory"));
+  printf("success.\n");
+}
+''')
+    check_execute([PYTHON, EMCC, 'src.c', '-s', 'MALLOC_HEAP_PROFILER=1', '--profiling-funcs'])
+    self.assertContained('live 100 (6144000 bytes), allocated 300, interval 4096\nsuccess.', run_js('a.out.js'))
+
+  def test_idbfs_journal(self): # after the first full sync, IDBFS stores only the paths that changed
+    check_execute([PYTHON, EMCC, path_from_root('tests', 'fs', 'test_idbfs_journal.c'), '-lidbfs.js', '-s', 'FORCE_FILESYSTEM=1', '--pre-js', path_from_root('tests', 'fs', 'fake_indexeddb.js')])
+    self.assertContained('transactions: 1, cursors: 0, puts: 4, deletes: 3\nsuccess', run_js('a.out.js'))
+
+  def test_aio(self): # aio requests run on later turns of the event loop, and report back through the aiocb
+    check_execute([PYTHON, EMCC, path_from_root('tests', 'fs', 'test_aio.c'), '-lidbfs.js', '--pre-js', path_from_root('tests', 'fs', 'fake_indexeddb.js')])
+    self.assertContained('reads queued\nreads completed\nsuspend and cancel work\nwrite completed\nfsync completed\nsuccess', run_js('a.out.js'))
+
+  def test_split_memory_spaces(self): # large allocations get their own chunks, and emptied chunks are reused
+    open('src.c', 'w').write(r'''
+#include <emscripten.h>
+#include <stdlib.h>
+#include <assert.h>
+int split_memory;
+int where(void *x) {
+  return (unsigned)x / split_memory;
+}
+int main() {
+  split_memory = EM_ASM_INT({
+    return SPLIT_MEMORY;
+  });
+  void *small = malloc(100);
+  void *large = malloc(split_memory / 4);
+  printf("small: %d, large: %d\n", where(small), where(large));
+  assert(where(large) != where(small));
+  void *small2 = malloc(200);
+  assert(where(small2) == where(small));
+  // a single allocation that keeps being freed and made again stays in the same chunk
+  for (int i = 0; i < 100; i++) {
+    free(large);
+    void *again = malloc(split_memory / 4);
+    assert(where(again) == where(large));
+    large = again;
+  }
+  EM_ASM( Module.print('success.') );
+}
 ''')
     for opts in [0, 1, 2]:
       print(opts)
@@ -461,6 +461,13 @@ int main () {
       with harness:
         self.btest(os.path.join('sockets', 'test_sockets_select_server_closes_connection_client_rw.c'), expected='266', args=[sockets_include, '-DSOCKK=%d' % harness.listen_port])
 
+  def test_sockets_mmsg(self):
+    # Run with ./runner.py sockets.test_sockets_mmsg; the client prints how long
+    # per-message and batched sends take to echo through websockify
+    if WINDOWS: return self.skip('This test is Unix-specific.')
+    with WebsockifyServerHarness(os.path.join('sockets', 'test_sockets_mmsg_server.c'), [], 49220):
+      self.btest(os.path.join('sockets', 'test_sockets_mmsg_client.c'), expected='0', args=['-DSOCKK=49220'])
+
   def test_enet(self):
     if WINDOWS: return self.skip('This test uses Unix-specific build architecture.')
     # this is also a good test of raw usage of emconfigure and emmake
@@ -93,7 +93,7 @@ def eval_ctors_js(js, mem_init, num):
         'HEAPF32', 'HEAPF64',
         'Int8View', 'Int16View', 'Int32View', 'Uint8View', 'Uint16View', 'Uint32View', 'Float32View', 'Float64View',
         'nan', 'inf',
-        '_emscripten_memcpy_big', '___dso_handle',
+        '_emscripten_memcpy_big', '_emscripten_memset_big', '___dso_handle',
         '_atexit', '___cxa_atexit',
       ] or name.startswith('Math_'):
         if 'new ' not in value:
@@ -182,6 +182,10 @@ var libraryArg = {
     heap.set(heap.subarray(src, src+num), dest);
     return dest;
   },
+  _emscripten_memset_big: function(ptr, value, num) {
+    heap.fill(value, ptr, ptr+num);
+    return ptr;
+  },
   _atexit: function(x) {
     atexits.push([x, 0]);
     return 0;
@@ -40,7 +40,9 @@ Usage:
 
   --no-force Don't create output if no valid input file is specified.
 
-  --use-preload-cache Stores package in IndexedDB so that subsequent loads don't need to do XHR. Checks package version.
+  --use-preload-cache Stores package in IndexedDB so that subsequent loads don't need to do XHR. The package is cached in chunks
+                      addressed by their content, so when it changes, only the chunks that are not cached yet are downloaded
+                      (using HTTP range requests, if the server supports them).
 
   --indexedDB-name Use specified IndexedDB database name (Default: 'EM_PRELOAD_CACHE')
 
@@ -66,7 +68,7 @@ TODO:        You can also provide .crn files yourself, pre-crunched. With this o
 '''
 
 from __future__ import print_function
-import os, sys, shutil, random, uuid, ctypes
+import os, sys, shutil, random, uuid, ctypes, hashlib
 
 sys.path.insert(1, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
 
@@ -101,6 +103,10 @@ DDS_HEADER_SIZE = 128
 
 AV_WORKAROUND = 0 # Set to 1 to randomize file order and add some padding, to work around silly av false positives
 
+# Target size of the content-addressed chunks that --use-preload-cache stores the package in. Larger files are split into
+# chunks of this size, smaller ones are grouped into chunks of up to this size.
+CACHE_CHUNK_SIZE = 1024*1024
+
 data_files = []
 excluded_patterns = []
 export_name = 'Module'
@@ -411,9 +417,16 @@ if has_preloaded:
   # Bundle all datafiles into one archive. Avoids doing lots of simultaneous XHRs which has overhead.
   data = open(data_target, 'wb')
   start = 0
+  stored = {} # content hash => file whose data is in the archive. Files with identical contents share it.
   for file_ in data_files:
-    file_['data_start'] = start
     curr = open(file_['srcpath'], 'rb').read()
+    file_['hash'] = hashlib.sha256(curr).hexdigest()
+    if file_['hash'] in stored:
+      file_['data_start'] = stored[file_['hash']]['data_start']
+      file_['data_end'] = stored[file_['hash']]['data_end']
+      continue
+    stored[file_['hash']] = file_
+    file_['data_start'] = start
     file_['data_end'] = start + len(curr)
     if AV_WORKAROUND: curr += '\x00'
     #print >> sys.stderr, 'bundling', file_['srcpath'], file_['dstpath'], file_['data_start'], file_['data_end']
@@ -442,11 +455,12 @@ if has_preloaded:
 
   # Data requests - for getting a block of data out of the big archive - have a similar API to XHRs
   code += '''
-    function DataRequest(start, end, crunched, audio) {
+    function DataRequest(start, end, crunched, audio, shared) {
       this.start = start;
       this.end = end;
       this.crunched = crunched;
       this.audio = audio;
+      this.shared = shared;
     }
     DataRequest.prototype = {
       requests: {},
@@ -458,6 +472,7 @@ if has_preloaded:
       send: function() {},
       onload: function() {
         var byteArray = this.byteArray.subarray(this.start, this.end);
+        if (this.shared) byteArray = new Uint8Array(byteArray); // files own their data, so another file with the same contents needs a copy
 %s
           this.finish(byteArray);
 %s
@@ -485,7 +500,7 @@ if has_preloaded:
 ''', create_preloaded if use_preload_plugins else create_data, '''
         var files = metadata.files;
         for (var i = 0; i < files.length; ++i) {
-          new DataRequest(files[i].start, files[i].end, files[i].crunched, files[i].audio).open('GET', files[i].filename);
+          new DataRequest(files[i].start, files[i].end, files[i].crunched, files[i].audio, files[i].shared).open('GET', files[i].filename);
         }
 ''' if not lz4 else '')
 
@@ -519,6 +534,8 @@ for file_ in data_files:
       'crunched': 1 if crunch and filename.endswith(CRUNCH_INPUT_SUFFIX) else 0,
       'audio': 1 if filename[-4:] in AUDIO_SUFFIXES else 0,
     })
+    if stored[file_['hash']] is not file_:
+      metadata['files'][-1]['shared'] = 1
   else:
     assert 0
 
@@ -561,6 +578,40 @@ if has_preloaded:
           Module['removeRunDependency']('datafile_%s');
     ''' % (meta, escape_for_js_string(data_target))
 
+  if use_preload_cache:
+    # Split the archive into chunks named by the hash of their contents, so that the cache can tell which of them it
+    # already has when the package changes. Chunks of files follow the files, so a changed file does not change the
+    # chunks of the others, even when it moves them. Small files are grouped together, and a group also ends after a
+    # file whose hash happens to start with 0, so that adding or removing a file only regroups the files near it.
+    # LZ4 packages compress the archive as a whole, so those are just split evenly.
+    archive = open(data_target, 'rb').read()
+    boundaries = set([0, len(archive)])
+    if lz4:
+      boundaries.update(range(0, len(archive), CACHE_CHUNK_SIZE))
+    else:
+      group_start = 0
+      for file_ in data_files:
+        if stored[file_['hash']] is not file_: continue
+        start, end = file_['data_start'], file_['data_end']
+        if end - start >= CACHE_CHUNK_SIZE:
+          boundaries.update(range(start, end, CACHE_CHUNK_SIZE))
+          boundaries.add(end)
+          group_start = end
+          continue
+        if end - group_start > CACHE_CHUNK_SIZE:
+          boundaries.add(start)
+          group_start = start
+        if file_['hash'][0] == '0':
+          boundaries.add(end)
+          group_start = end
+    boundaries = sorted(boundaries)
+    metadata['chunks'] = [{
+      'hash': hashlib.sha256(archive[start:end]).hexdigest(),
+      'start': start,
+      'end': end,
+    } for start, end in zip(boundaries, boundaries[1:])]
+    archive = None
+
   package_uuid = uuid.uuid4();
   package_name = data_target
   statinfo = os.stat(package_name)
@@ -599,9 +650,9 @@ if has_preloaded:
       var IDB_RO = "readonly";
       var IDB_RW = "readwrite";
       var DB_NAME = "''' + indexeddb_name + '''";
-      var DB_VERSION = 1;
+      var DB_VERSION = 2;
       var METADATA_STORE_NAME = 'METADATA';
-      var PACKAGE_STORE_NAME = 'PACKAGES';
+      var CHUNK_STORE_NAME = 'CHUNKS';
       function openDatabase(callback, errback) {
         try {
           var openRequest = indexedDB.open(DB_NAME, DB_VERSION);
@@ -611,10 +662,14 @@ if has_preloaded:
         openRequest.onupgradeneeded = function(event) {
           var db = event.target.result;
 
-          if(db.objectStoreNames.contains(PACKAGE_STORE_NAME)) {
-            db.deleteObjectStore(PACKAGE_STORE_NAME);
+          if(db.objectStoreNames.contains('PACKAGES')) {
+            db.deleteObjectStore('PACKAGES'); // whole packages, as stored by version 1
           }
-          var packages = db.createObjectStore(PACKAGE_STORE_NAME);
+
+          if(db.objectStoreNames.contains(CHUNK_STORE_NAME)) {
+            db.deleteObjectStore(CHUNK_STORE_NAME);
+          }
+          var chunks = db.createObjectStore(CHUNK_STORE_NAME);
 
           if(db.objectStoreNames.contains(METADATA_STORE_NAME)) {
             db.deleteObjectStore(METADATA_STORE_NAME);
@@ -630,58 +685,157 @@ if has_preloaded:
         };
       };
 
-      /* Check if there's a cached package, and if so whether it's the latest available */
-      function checkCachedPackage(db, packageName, callback, errback) {
-        var transaction = db.transaction([METADATA_STORE_NAME], IDB_RO);
-        var metadata = transaction.objectStore(METADATA_STORE_NAME);
+      /* Look up each chunk of the package in the cache, calls back with their data, or null for the ones not cached */
+      function fetchCachedChunks(db, chunks, callback, errback) {
+        var transaction = db.transaction([CHUNK_STORE_NAME], IDB_RO);
+        var store = transaction.objectStore(CHUNK_STORE_NAME);
+
+        var cached = [];
+        var pending = chunks.length;
+        var failed = false;
+        if (!pending) return callback(cached);
+        chunks.forEach(function(chunk, i) {
+          var getRequest = store.get("chunk/" + chunk.hash);
+          getRequest.onsuccess = function(event) {
+            cached[i] = event.target.result || null;
+            if (--pending === 0) callback(cached);
+          };
+          getRequest.onerror = function(error) {
+            if (failed) return;
+            failed = true;
+            errback(error);
+          };
+        });
+      };
 
-        var getRequest = metadata.get("metadata/" + packageName);
-        getRequest.onsuccess = function(event) {
-          var result = event.target.result;
-          if (!result) {
-            return callback(false);
-          } else {
-            return callback(PACKAGE_UUID === result.uuid);
-          }
+      /* Store the chunks that were downloaded, and forget the ones that no package uses any more. Packages in the same
+         database can share chunks, so each chunk keeps a count of the packages that use it */
+      function cacheChunks(db, packageName, chunks, data, downloaded, callback, errback) {
+        var transaction = db.transaction([METADATA_STORE_NAME, CHUNK_STORE_NAME], IDB_RW);
+        var metadata = transaction.objectStore(METADATA_STORE_NAME);
+        var store = transaction.objectStore(CHUNK_STORE_NAME);
+        var failed = false;
+        transaction.oncomplete = function(event) {
+          callback();
         };
-        getRequest.onerror = function(error) {
+        transaction.onerror = function(error) {
+          if (failed) return;
+          failed = true;
           errback(error);
         };
-      };
 
-      function fetchCachedPackage(db, packageName, callback, errback) {
-        var transaction = db.transaction([PACKAGE_STORE_NAME], IDB_RO);
-        var packages = transaction.objectStore(PACKAGE_STORE_NAME);
+        function addReference(hash, delta) {
+          var getRefsRequest = metadata.get("refs/" + hash);
+          getRefsRequest.onsuccess = function(event) {
+            var refs = (event.target.result || 0) + delta;
+            if (refs > 0) {
+              metadata.put(refs, "refs/" + hash);
+            } else {
+              metadata.delete("refs/" + hash);
+              store.delete("chunk/" + hash);
+            }
+          };
+        };
 
-        var getRequest = packages.get("package/" + packageName);
+        var getRequest = metadata.get("metadata/" + packageName);
         getRequest.onsuccess = function(event) {
-          var result = event.target.result;
-          callback(result);
-        };
-        getRequest.onerror = function(error) {
-          errback(error);
+          var hashes = {};
+          chunks.forEach(function(chunk) {
+            hashes[chunk.hash] = 1;
+          });
+          var previous = event.target.result;
+          var previousHashes = {};
+          if (previous && previous.chunks) {
+            previous.chunks.forEach(function(hash) {
+              previousHashes[hash] = 1;
+            });
+          }
+          for (var hash in hashes) {
+            if (!previousHashes[hash]) addReference(hash, 1);
+          }
+          for (var hash in previousHashes) {
+            if (!hashes[hash]) addReference(hash, -1);
+          }
+          downloaded.forEach(function(i) {
+            store.put(data[i], "chunk/" + chunks[i].hash);
+          });
+          metadata.put({uuid: PACKAGE_UUID, chunks: Object.keys(hashes)}, "metadata/" + packageName);
         };
       };
 
-      function cacheRemotePackage(db, packageName, packageData, packageMeta, callback, errback) {
-        var transaction_packages = db.transaction([PACKAGE_STORE_NAME], IDB_RW);
-        var packages = transaction_packages.objectStore(PACKAGE_STORE_NAME);
-
-        var putPackageRequest = packages.put(packageData, "package/" + packageName);
-        putPackageRequest.onsuccess = function(event) {
-          var transaction_metadata = db.transaction([METADATA_STORE_NAME], IDB_RW);
-          var metadata = transaction_metadata.objectStore(METADATA_STORE_NAME);
-          var putMetadataRequest = metadata.put(packageMeta, "metadata/" + packageName);
-          putMetadataRequest.onsuccess = function(event) {
-            callback(packageData);
+      /* Download the given chunks, as few ranges of the package as possible */
+      function fetchRemoteChunks(packageName, packageSize, chunks, wanted, data, callback, errback) {
+        var ranges = [];
+        wanted.forEach(function(i) {
+          var last = ranges[ranges.length-1];
+          if (last && last.end === chunks[i].start) {
+            last.end = chunks[i].end;
+            last.chunks.push(i);
+          } else {
+            ranges.push({start: chunks[i].start, end: chunks[i].end, chunks: [i]});
+          }
+        });
+        var pending = ranges.length;
+        var failed = false;
+        function fail(error) {
+          if (failed) return;
+          failed = true;
+          errback(error);
+        }
+        function received(range, buffer, offset) {
+          if (failed) return;
+          range.chunks.forEach(function(i) {
+            data[i] = buffer.slice(chunks[i].start - offset, chunks[i].end - offset);
+          });
+          if (--pending === 0) callback();
+        }
+        function fetchRange(range, callback) {
+          if (range.end - range.start === packageSize) {
+            return fetchRemotePackage(packageName, packageSize, function(packageData) {
+              callback(packageData, true);
+            }, fail);
+          }
+          var xhr = new XMLHttpRequest();
+          xhr.open('GET', packageName, true);
+          xhr.responseType = 'arraybuffer';
+          xhr.setRequestHeader('Range', 'bytes=' + range.start + '-' + (range.end - 1));
+          xhr.onerror = function(event) {
+            fail(new Error("NetworkError for: " + packageName));
           };
-          putMetadataRequest.onerror = function(error) {
-            errback(error);
+          xhr.onload = function(event) {
+            if (xhr.status == 206) {
+              callback(xhr.response, false);
+            } else if (xhr.status == 200 || xhr.status == 304 || (xhr.status == 0 && xhr.response)) {
+              callback(xhr.response, true); // the server sent the whole package
+            } else {
+              fail(new Error(xhr.statusText + " : " + xhr.responseURL));
+            }
           };
-        };
-        putPackageRequest.onerror = function(error) {
-          errback(error);
-        };
+          xhr.send(null);
+        }
+        // if the server ignores ranges, the first response has everything
+        fetchRange(ranges[0], function(buffer, whole) {
+          if (whole) {
+            ranges.forEach(function(range) {
+              received(range, buffer, 0);
+            });
+            return;
+          }
+          received(ranges[0], buffer, ranges[0].start);
+          ranges.slice(1).forEach(function(range) {
+            fetchRange(range, function(buffer, whole) {
+              received(range, buffer, whole ? 0 : range.start);
+            });
+          });
+        });
+      };
+
+      function assemblePackage(packageSize, chunks, data) {
+        var packageData = new Uint8Array(packageSize);
+        chunks.forEach(function(chunk, i) {
+          packageData.set(new Uint8Array(data[i]), chunk.start);
+        });
+        return packageData.buffer;
       };
     '''
 
@@ -765,24 +919,36 @@ if has_preloaded:
 
       openDatabase(
         function(db) {
-          checkCachedPackage(db, PACKAGE_PATH + PACKAGE_NAME,
-            function(useCached) {
-              Module.preloadResults[PACKAGE_NAME] = {fromCache: useCached};
-              if (useCached) {
+          var chunks = metadata.chunks;
+          fetchCachedChunks(db, chunks,
+            function(data) {
+              var missing = [];
+              var missingSize = 0;
+              chunks.forEach(function(chunk, i) {
+                if (!data[i]) {
+                  missing.push(i);
+                  missingSize += chunk.end - chunk.start;
+                }
+              });
+              Module.preloadResults[PACKAGE_NAME] = {fromCache: !missing.length, downloaded: missingSize};
+              if (!missing.length) {
                 console.info('loading ' + PACKAGE_NAME + ' from cache');
-                fetchCachedPackage(db, PACKAGE_PATH + PACKAGE_NAME, processPackageData, preloadFallback);
-              } else {
-                console.info('loading ' + PACKAGE_NAME + ' from remote');
-                fetchRemotePackage(REMOTE_PACKAGE_NAME, REMOTE_PACKAGE_SIZE, 
-                  function(packageData) {
-                    cacheRemotePackage(db, PACKAGE_PATH + PACKAGE_NAME, packageData, {uuid:PACKAGE_UUID}, processPackageData,
-                      function(error) {
-                        console.error(error);
-                        processPackageData(packageData);
-                      });
-                  }
-                , preloadFallback);
+                return processPackageData(assemblePackage(REMOTE_PACKAGE_SIZE, chunks, data));
               }
+              console.info('loading ' + PACKAGE_NAME + ' from remote (' + missingSize + ' of ' + REMOTE_PACKAGE_SIZE + ' bytes)');
+              fetchRemoteChunks(REMOTE_PACKAGE_NAME, REMOTE_PACKAGE_SIZE, chunks, missing, data,
+                function() {
+                  var packageData = assemblePackage(REMOTE_PACKAGE_SIZE, chunks, data);
+                  cacheChunks(db, PACKAGE_PATH + PACKAGE_NAME, chunks, data, missing,
+                    function() {
+                      processPackageData(packageData);
+                    },
+                    function(error) {
+                      console.error(error);
+                      processPackageData(packageData);
+                    });
+                }
+              , preloadFallback);
             }
           , preloadFallback);
         }
@@ -1,6 +1,6 @@
 
 from __future__ import print_function
-import os, sys, subprocess, multiprocessing, re, string, json, shutil, logging
+import os, sys, subprocess, multiprocessing, re, string, json, shutil, logging, heapq
 
 sys.path.insert(1, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
 
@@ -55,6 +55,57 @@ def split_funcs(js, just_split=False):
     funcs.append((ident, func))
   return funcs
 
+# Estimates how long the optimizer will take on a function. Optimizer time grows
+# about linearly with the amount of code in a function, as measureCost's node
+# count does, so its text length is a good enough stand-in.
+def estimate_cost(func):
+  return len(func[1])
+
+# Splits functions into chunks for parallel optimization. Functions that cost as
+# much as a whole chunk should get are optimized on their own, and the rest are
+# dealt out largest first, each to the chunk that is cheapest so far, so that the
+# chunks come out about even. If keep_order, chunks are contiguous runs of funcs
+# instead, so the output can keep the input order. Returns a list of
+# (cost, text) in output order.
+def chunk_funcs(funcs, cores, keep_order=False):
+  costs = [estimate_cost(func) for func in funcs]
+  total_cost = sum(costs)
+  intended_num_chunks = int(round(cores * NUM_CHUNKS_PER_CORE))
+  chunk_cost = min(MAX_CHUNK_SIZE, max(MIN_CHUNK_SIZE, total_cost // intended_num_chunks))
+
+  if keep_order:
+    # a function's cost is its length, so a chunk's cost is too
+    return [(len(chunk), chunk) for chunk in shared.chunkify(funcs, chunk_cost) if chunk]
+
+  indexes = sorted(range(len(funcs)), key=lambda i: (-costs[i], i))
+  chunks = []
+  rest = []
+  rest_cost = 0
+  for i in indexes:
+    if costs[i] >= chunk_cost:
+      chunks.append([costs[i], [i]])
+    else:
+      rest.append(i)
+      rest_cost += costs[i]
+  if rest:
+    # a heap of (cost so far, chunk index), so ties go to the older chunk
+    num_bins = max(1, -(-rest_cost // chunk_cost))
+    bins = [[0, []] for j in range(num_bins)]
+    heap = [(0, j) for j in range(num_bins)]
+    for i in rest:
+      cost, j = heapq.heappop(heap)
+      if cost and cost + costs[i] > MAX_CHUNK_SIZE:
+        # even the cheapest chunk is full; start another
+        heapq.heappush(heap, (cost, j))
+        bins.append([0, []])
+        cost, j = 0, len(bins) - 1
+      bins[j][0] += costs[i]
+      bins[j][1].append(i)
+      heapq.heappush(heap, (bins[j][0], j))
+    chunks += [b for b in bins if b[1]]
+  # within a chunk, keep functions in their original order
+  return [(cost, ''.join(funcs[i][1] for i in sorted(members))) for cost, members in chunks]
+
 def get_native_optimizer():
   if os.environ.get('EMCC_FAST_COMPILER') == '0':
     logging.critical('Non-fastcomp compiler is no longer available, please use fastcomp or an older version of emscripten')
@@ -407,13 +458,17 @@ EMSCRIPTEN_FUNCS();
     cores = 1 if source_map else int(os.environ.get('EMCC_CORES') or multiprocessing.cpu_count())
 
     if not just_split:
-      intended_num_chunks = int(round(cores * NUM_CHUNKS_PER_CORE))
-      chunk_size = min(MAX_CHUNK_SIZE, max(MIN_CHUNK_SIZE, total_size / intended_num_chunks))
-      chunks = shared.chunkify(funcs, chunk_size)
+      # when the output is not sorted afterwards, it must stay in input order
+      keep_order = just_concat or os.environ.get('EMCC_NO_OPT_SORT')
+      chunks = chunk_funcs(funcs, cores, keep_order)
+      chunk_costs = [chunk[0] for chunk in chunks]
+      chunks = [chunk[1] for chunk in chunks]
     else:
       # keep same chunks as before
       chunks = [f[1] for f in funcs]
+      chunk_costs = [estimate_cost(f) for f in funcs]
 
+    chunk_costs = [chunk_costs[i] for i in range(len(chunks)) if len(chunks[i]) > 0]
     chunks = [chunk for chunk in chunks if len(chunk) > 0]
     if DEBUG and len(chunks) > 0: print('chunkification: num funcs:', len(funcs), 'actual num chunks:', len(chunks), 'chunk size range:', max(map(len, chunks)), '-', min(map(len, chunks)), file=sys.stderr)
     funcs = None
@@ -455,7 +510,14 @@ EMSCRIPTEN_FUNCS();
         if DEBUG: print('splitting up js optimization into %d chunks, using %d cores  (total: %.2f MB)' % (len(chunks), cores, total_size/(1024*1024.)), file=sys.stderr)
         with ToolchainProfiler.profile_block('optimizer_pool'):
           pool = shared.Building.get_multiprocessing_pool()
-          filenames = pool.map(run_on_chunk, commands, chunksize=1)
+          # hand out the most expensive chunks first, so that whichever worker is
+          # free takes the next one and the pool finishes together, instead of
+          # waiting on a big chunk that started last
+          order = sorted(range(len(commands)), key=lambda i: (-chunk_costs[i], i))
+          outputs = pool.map(run_on_chunk, [commands[i] for i in order], chunksize=1)
+          filenames = [None] * len(commands)
+          for i, output in zip(order, outputs):
+            filenames[i] = output
       else:
         # We can't parallize, but still break into chunks to avoid uglify/node memory issues
         if len(chunks) > 1 and DEBUG: print('splitting up js optimization into %d chunks' % (len(chunks)), file=sys.stderr)
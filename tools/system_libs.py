@@ -293,10 +293,28 @@ def calculate(temp_files, in_temp, stdout_, stderr_, forced=[]):
     shared.Building.emar('cr', in_temp(libname), o_s)
     return in_temp(libname)
 
+  def use_malloc_heap_profiler():
+    # The profiler keeps its samples and stack symbols unsynchronized on one thread, and split_malloc provides its own malloc().
+    return shared.Settings.MALLOC_HEAP_PROFILER and not shared.Settings.USE_PTHREADS and not shared.Settings.SPLIT_MEMORY
+
+  def use_malloc_thread_cache():
+    # Thread caches hide allocations from the tracing hooks in dlmalloc, and split_malloc provides its own malloc().
+    return shared.Settings.USE_PTHREADS and shared.Settings.MALLOC_THREAD_CACHE and not shared.Settings.EMSCRIPTEN_TRACING and not shared.Settings.SPLIT_MEMORY
+
+  def use_malloc_large_region():
+    # split_malloc only uses mspaces, which get no large chunk region.
+    return shared.Settings.MALLOC_LARGE_OBJECT_REGION and not shared.Settings.SPLIT_MEMORY
+
   def dlmalloc_name():
     ret = 'dlmalloc'
     if shared.Settings.USE_PTHREADS:
       ret += '_threadsafe'
+    if use_malloc_thread_cache():
+      ret += '_threadcache'
+    if use_malloc_large_region():
+      ret += '_largeregion'
+    if use_malloc_heap_profiler():
+      ret += '_heapprofiler'
     if shared.Settings.EMSCRIPTEN_TRACING:
       ret += '_tracing'
     if shared.Settings.SPLIT_MEMORY:
@@ -316,7 +334,25 @@ def calculate(temp_files, in_temp, stdout_, stderr_, forced=[]):
       cflags += ['-DMSPACES', '-DONLY_MSPACES']
     if shared.Settings.DEBUG_LEVEL:
       cflags += ['-DDLMALLOC_DEBUG']
+    if use_malloc_thread_cache():
+      cflags += ['-DDLMALLOC_THREAD_CACHE=1']
+    if use_malloc_large_region():
+      cflags += ['-DDLMALLOC_LARGE_REGION=1']
+    if use_malloc_heap_profiler():
+      cflags += ['-DDLMALLOC_HEAP_PROFILER=1']
     check_call([shared.PYTHON, shared.EMCC, shared.path_from_root('system', 'lib', 'dlmalloc.c'), '-o', o] + cflags)
+    if use_malloc_heap_profiler():
+      heap_profiler_o = in_temp('hp' + out_name)
+      check_call([shared.PYTHON, shared.EMCC, shared.path_from_root('system', 'lib', 'heap_profiler.c'), '-o', heap_profiler_o, '-O2'])
+      lib = in_temp('lib' + out_name)
+      shared.Building.link([o, heap_profiler_o], lib)
+      shutil.move(lib, o)
+    if use_malloc_thread_cache():
+      thread_cache_o = in_temp('tc' + out_name)
+      check_call([shared.PYTHON, shared.EMCC, shared.path_from_root('system', 'lib', 'thread_cache_malloc.c'), '-o', thread_cache_o, '-O2', '-s', 'USE_PTHREADS=1'])
+      lib = in_temp('lib' + out_name)
+      shared.Building.link([o, thread_cache_o], lib)
+      shutil.move(lib, o)
     if shared.Settings.SPLIT_MEMORY:
       split_malloc_o = in_temp('sm' + out_name)
       check_call([shared.PYTHON, shared.EMCC, shared.path_from_root('system', 'lib', 'split_malloc.cpp'), '-o', split_malloc_o, '-O2'])
@@ -464,6 +500,8 @@ def calculate(temp_files, in_temp, stdout_, stderr_, forced=[]):
     system_libs += [('libc', 'bc', create_libc, libc_symbols, [], False)]
 
   force.add(dlmalloc_name())
+  if use_malloc_heap_profiler():
+    force.add('libc') # the profiler writes its dumps with stdio
 
   # if building to wasm, we need more math code, since we have less builtins
   if shared.Settings.BINARYEN: